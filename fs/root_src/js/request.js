@@ -18,3 +18,17 @@ function JSONrequest(method, url, done_cb, error_cb, data) {
 	}
 	request.send(data);
 }
+
+function eventStream(url, event, event_cb, open_cb) {
+	if (typeof EventSource === 'undefined') {
+		return null;
+	}
+	var source = new EventSource(url);
+	source.addEventListener(event, function(e) {
+		event_cb(JSON.parse(e.data));
+	});
+	if (open_cb !== undefined) {
+		source.onopen = open_cb;
+	}
+	return source;
+}
@@ -0,0 +1,157 @@
+/* JSON request decoding.
+ *
+ * Decodes the bodies of the REST PUT requests with json_decode, and
+ * with jsmn tokens and key compares, like the handlers used to.
+ */
+#include <stdlib.h>
+#include "tools/missing_dec.h"
+#include "c_types.h"
+#include "osapi.h"
+#include "user_config.h"
+#include "tools/json-decode.h"
+#include "jsmn.h"
+#include "bench.h"
+
+#define RUNS 1000000UL
+
+#define N_TOKENS 32
+
+static const char gpio_json[] = "{\"state\":1}";
+static const char network_json[] =
+	"{\"network\":\"thirtytwocharsthirtytwocharsXXXX\",\"hostname\":\"wifiswitch\"}";
+static const char extra_json[] =
+	"{\"version\":\"0.1\",\"aps\":[1,2,3,4],\"ap\":{\"ssid\":\"x\",\"rssi\":-70},"
+	"\"network\":\"my-network\",\"hostname\":\"wifiswitch\"}";
+
+static char ssid[33];
+static char hostname[32];
+static signed long state;
+
+static const struct json_field network_fields[] =
+{
+	{ "network", JSON_FIELD_STRING, ssid, sizeof(ssid) },
+	{ "hostname", JSON_FIELD_STRING, hostname, sizeof(hostname) }
+};
+static const struct json_field gpio_fields[] =
+{
+	{ "state", JSON_FIELD_NUMBER, &state, sizeof(state) }
+};
+
+static bool token_is(const char *json, jsmntok_t *token, const char *str)
+{
+	size_t size = os_strlen(str);
+
+	return((token->type == JSMN_STRING) &&
+		   ((size_t)(token->end - token->start) == size) &&
+		   (os_strncmp(json + token->start, str, size) == 0));
+}
+
+static bool copy_token(const char *json, jsmntok_t *token, char *dest,
+					   size_t size)
+{
+	size_t len = token->end - token->start;
+
+	if ((token->type != JSMN_STRING) || (len >= size))
+	{
+		return(false);
+	}
+	os_memcpy(dest, json + token->start, len);
+	dest[len] = '\0';
+	return(true);
+}
+
+/* Find the members of an object, skipping values that are not wanted. */
+static signed int jsmn_network(const char *json, size_t size)
+{
+	jsmn_parser parser;
+	jsmntok_t tokens[N_TOKENS];
+	signed int found = 0;
+	int n_tokens;
+	int i;
+	int end;
+
+	jsmn_init(&parser);
+	n_tokens = jsmn_parse(&parser, json, size, tokens, N_TOKENS);
+	if ((n_tokens < 1) || (tokens[0].type != JSMN_OBJECT))
+	{
+		return(-1);
+	}
+	i = 1;
+	while (i + 1 < n_tokens)
+	{
+		if (token_is(json, &tokens[i], "network"))
+		{
+			if (!copy_token(json, &tokens[i + 1], ssid, sizeof(ssid)))
+			{
+				return(-1);
+			}
+			found |= 1;
+		}
+		else if (token_is(json, &tokens[i], "hostname"))
+		{
+			if (!copy_token(json, &tokens[i + 1], hostname, sizeof(hostname)))
+			{
+				return(-1);
+			}
+			found |= 2;
+		}
+		//Skip the value, and anything inside it.
+		end = tokens[i + 1].end;
+		i += 2;
+		while ((i < n_tokens) && (tokens[i].start < end))
+		{
+			i++;
+		}
+	}
+	return(found);
+}
+
+static signed int jsmn_gpio(const char *json, size_t size)
+{
+	jsmn_parser parser;
+	jsmntok_t tokens[N_TOKENS];
+	int n_tokens;
+
+	jsmn_init(&parser);
+	n_tokens = jsmn_parse(&parser, json, size, tokens, N_TOKENS);
+	if ((n_tokens != 3) || (tokens[0].type != JSMN_OBJECT) ||
+		(!token_is(json, &tokens[1], "state")) ||
+		(tokens[2].type != JSMN_PRIMITIVE))
+	{
+		return(-1);
+	}
+	state = strtol(json + tokens[2].start, NULL, 10);
+	return(1);
+}
+
+int main(void)
+{
+	//Both must find the same.
+	if ((json_decode(extra_json, sizeof(extra_json) - 1, network_fields, 2) != 3) ||
+		(jsmn_network(extra_json, sizeof(extra_json) - 1) != 3) ||
+		(json_decode(network_json, sizeof(network_json) - 1, network_fields, 2) != 3) ||
+		(jsmn_network(network_json, sizeof(network_json) - 1) != 3) ||
+		(os_strcmp(ssid, "thirtytwocharsthirtytwocharsXXXX")) ||
+		(json_decode(gpio_json, sizeof(gpio_json) - 1, gpio_fields, 1) != 1) ||
+		(jsmn_gpio(gpio_json, sizeof(gpio_json) - 1) != 1) || (state != 1))
+	{
+		printf("Decoders disagree.\n");
+		return(1);
+	}
+	BENCH("json_decode, GPIO state", RUNS,
+		  bench_sink += json_decode(gpio_json, sizeof(gpio_json) - 1,
+									gpio_fields, 1));
+	BENCH("jsmn, GPIO state", RUNS,
+		  bench_sink += jsmn_gpio(gpio_json, sizeof(gpio_json) - 1));
+	BENCH("json_decode, network", RUNS,
+		  bench_sink += json_decode(network_json, sizeof(network_json) - 1,
+									network_fields, 2));
+	BENCH("jsmn, network", RUNS,
+		  bench_sink += jsmn_network(network_json, sizeof(network_json) - 1));
+	BENCH("json_decode, network with unknown members", RUNS,
+		  bench_sink += json_decode(extra_json, sizeof(extra_json) - 1,
+									network_fields, 2));
+	BENCH("jsmn, network with unknown members", RUNS,
+		  bench_sink += jsmn_network(extra_json, sizeof(extra_json) - 1));
+	return(0);
+}
@@ -0,0 +1,123 @@
+/* JSON array generation.
+ *
+ * Builds an array of small objects, like the network names list, with
+ * json_add_to_array, which reallocates and copies the string for every
+ * element, and with the writer, which measures, allocates once and
+ * writes.
+ */
+#include <stdlib.h>
+#include "tools/missing_dec.h"
+#include "c_types.h"
+#include "osapi.h"
+#include "user_config.h"
+#include "tools/json-gen.h"
+#include "tools/json-writer.h"
+#include "bench.h"
+
+#define RUNS 100000UL
+
+static char names[200][12];
+
+static char *build_json_gen(unsigned int n)
+{
+	char *array = NULL;
+	char *object;
+	char *pair;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+	{
+		pair = json_create_pair("ssid", names[i], true);
+		object = json_add_to_object(NULL, pair);
+		db_free(pair);
+		object = json_add_number(object, "channel", i % 13 + 1);
+		array = json_add_to_array(array, object);
+		db_free(object);
+	}
+	return(array);
+}
+
+static void write_array(struct json_writer *writer, unsigned int n)
+{
+	unsigned int i;
+
+	json_begin_array(writer);
+	for (i = 0; i < n; i++)
+	{
+		json_begin_object(writer);
+		json_key(writer, "ssid");
+		json_string(writer, names[i], os_strlen(names[i]));
+		json_key(writer, "channel");
+		json_number(writer, i % 13 + 1);
+		json_end_object(writer);
+	}
+	json_end_array(writer);
+}
+
+static char *build_json_writer(unsigned int n)
+{
+	struct json_writer writer;
+	size_t size;
+	char *array;
+
+	json_writer_init(&writer, NULL, 0);
+	write_array(&writer, n);
+	size = json_writer_size(&writer);
+	array = db_malloc(size + 1, "bench");
+	json_writer_init(&writer, array, size + 1);
+	write_array(&writer, n);
+	return(array);
+}
+
+int main(void)
+{
+	static const unsigned int sizes[] = { 10, 50, 200 };
+	char name[64];
+	char *array;
+	unsigned int i;
+	unsigned int n;
+
+	for (i = 0; i < 200; i++)
+	{
+		sprintf(names[i], "network-%u", i);
+	}
+	//Both must give the same JSON.
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		char *a = build_json_gen(sizes[i]);
+		char *b = build_json_writer(sizes[i]);
+
+		if (strcmp(a, b))
+		{
+			printf("Output differs for %u elements:\n%s\n%s\n", sizes[i], a, b);
+			return(1);
+		}
+		db_free(a);
+		db_free(b);
+	}
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		bench_allocs = 0;
+		db_free(build_json_gen(sizes[i]));
+		printf("%u elements: json_add_to_array %lu allocations, ", sizes[i],
+			   bench_allocs);
+		bench_allocs = 0;
+		db_free(build_json_writer(sizes[i]));
+		printf("json writer %lu\n", bench_allocs);
+	}
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		n = sizes[i];
+		sprintf(name, "json_add_to_array, %u elements", n);
+		BENCH(name, RUNS / n,
+			  array = build_json_gen(n);
+			  bench_sink += array[1];
+			  db_free(array));
+		sprintf(name, "json writer, %u elements", n);
+		BENCH(name, RUNS / n,
+			  array = build_json_writer(n);
+			  bench_sink += array[1];
+			  db_free(array));
+	}
+	return(0);
+}
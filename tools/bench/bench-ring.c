@@ -0,0 +1,52 @@
+/* Ring buffer push and pop.
+ *
+ * Compares copying items in and out, reserving and peeking in place,
+ * and the copy to the heap that ring_pop_front used to make for every
+ * item.
+ */
+#include <stdlib.h>
+#include "tools/missing_dec.h"
+#include "c_types.h"
+#include "osapi.h"
+#include "user_config.h"
+#include "tools/ring.h"
+#include "bench.h"
+
+#define RUNS 10000000UL
+
+struct item
+{
+	void *ptr;
+	size_t size;
+};
+
+int main(void)
+{
+	static struct item storage[16];
+	struct ring_buffer rb;
+	struct item item = { NULL, 1 };
+	struct item *slot;
+	void *copy;
+
+	init_ring(&rb, storage, sizeof(struct item), 16);
+	BENCH("ring_push_back + ring_pop_front", RUNS,
+		  item.size = bench_i;
+		  ring_push_back(&rb, &item);
+		  ring_pop_front(&rb, &item);
+		  bench_sink += item.size);
+	BENCH("ring_back/commit + ring_peek_front/drop", RUNS,
+		  slot = ring_back(&rb);
+		  slot->size = bench_i;
+		  ring_commit_back(&rb);
+		  bench_sink += ((struct item *)ring_peek_front(&rb))->size;
+		  ring_drop_front(&rb));
+	BENCH("push + pop with heap copy (old API)", RUNS,
+		  item.size = bench_i;
+		  ring_push_back(&rb, &item);
+		  copy = malloc(sizeof(struct item));
+		  os_memcpy(copy, ring_peek_front(&rb), sizeof(struct item));
+		  ring_drop_front(&rb);
+		  bench_sink += ((struct item *)copy)->size;
+		  free(copy));
+	return(0);
+}
@@ -0,0 +1,48 @@
+/* Timing helpers for the host benchmarks.
+ *
+ * BENCH runs a statement a number of times, and prints the average time
+ * it took. Results are only meant for comparing code paths on the same
+ * machine, the ESP8266 is a lot slower, and has a different heap.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Get the time in ns. */
+static inline uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/* Print the average time of an operation. */
+static inline void bench_report(const char *name, unsigned long n,
+								uint64_t ns)
+{
+	printf("%-44s %10.1f ns/op\n", name, (double)ns / n);
+}
+
+/* Time N runs of CODE. */
+#define BENCH(name, n, code) do \
+{ \
+	unsigned long bench_i; \
+	uint64_t bench_start = bench_now(); \
+	for (bench_i = 0; bench_i < (n); bench_i++) \
+	{ \
+		code; \
+	} \
+	bench_report(name, n, bench_now() - bench_start); \
+} while (0)
+
+/* Keep the compiler from optimising a result away. */
+extern volatile unsigned long bench_sink;
+
+/* Calls to os_malloc, os_zalloc and os_realloc. */
+extern unsigned long bench_allocs;
+
+#endif
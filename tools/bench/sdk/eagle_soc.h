@@ -0,0 +1 @@
+/* Host stand-in for the SDK eagle_soc.h, for the benchmarks. */
@@ -0,0 +1,10 @@
+/* Host stand-in for the SDK espconn.h, for the benchmarks. */
+#ifndef ESPCONN_H
+#define ESPCONN_H
+
+#include "c_types.h"
+#include "ip_addr.h"
+
+struct espconn;
+
+#endif
@@ -0,0 +1,2 @@
+/* Host stand-in for the SDK ets_sys.h, for the benchmarks. */
+#include "os_type.h"
@@ -0,0 +1,7 @@
+/* Host stand-in for the SDK gpio.h, for the benchmarks. */
+#ifndef GPIO_H
+#define GPIO_H
+
+#include "c_types.h"
+
+#endif
@@ -0,0 +1,17 @@
+/* Host stand-in for the SDK ip_addr.h, for the benchmarks. */
+#ifndef IP_ADDR_H
+#define IP_ADDR_H
+
+#include "c_types.h"
+
+struct ip_addr
+{
+	uint32_t addr;
+};
+typedef struct ip_addr ip_addr_t;
+
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) ((uint8_t *)(ipaddr))[0], ((uint8_t *)(ipaddr))[1], \
+					   ((uint8_t *)(ipaddr))[2], ((uint8_t *)(ipaddr))[3]
+
+#endif
@@ -0,0 +1,15 @@
+/* Host stand-in for the SDK mem.h, for the benchmarks. */
+#ifndef MEM_H
+#define MEM_H
+
+#include <stdlib.h>
+
+/* Counted, so the benchmarks can tell how often the heap is used. */
+extern unsigned long bench_allocs;
+
+#define os_malloc(size) (bench_allocs++, malloc(size))
+#define os_zalloc(size) (bench_allocs++, calloc(1, size))
+#define os_free free
+#define os_realloc(ptr, size) (bench_allocs++, realloc(ptr, size))
+
+#endif
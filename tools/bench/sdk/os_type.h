@@ -0,0 +1,24 @@
+/* Host stand-in for the SDK os_type.h, for the benchmarks. */
+#ifndef OS_TYPE_H
+#define OS_TYPE_H
+
+#include "c_types.h"
+
+typedef uint32_t os_signal_t;
+typedef uint32_t os_param_t;
+typedef struct
+{
+	os_signal_t sig;
+	os_param_t par;
+} os_event_t;
+typedef void (*os_task_t)(os_event_t *e);
+typedef void ETSTimerFunc(void *arg);
+typedef struct
+{
+	ETSTimerFunc *func;
+	void *arg;
+} ETSTimer;
+typedef ETSTimer os_timer_t;
+typedef ETSTimerFunc os_timer_func_t;
+
+#endif
@@ -0,0 +1,28 @@
+/* Host stand-in for the SDK osapi.h, for the benchmarks. */
+#ifndef OSAPI_H
+#define OSAPI_H
+
+#include <stdio.h>
+#include <string.h>
+#include "os_type.h"
+
+#define os_memcpy memcpy
+#define os_memmove memmove
+#define os_memset memset
+#define os_memcmp memcmp
+#define os_bzero(p, n) memset(p, 0, n)
+#define os_strlen strlen
+#define os_strcmp strcmp
+#define os_strncmp strncmp
+#define os_strcpy strcpy
+#define os_strncpy strncpy
+#define os_strstr strstr
+#define os_strchr strchr
+#define os_sprintf sprintf
+#define os_printf printf
+
+void os_timer_disarm(os_timer_t *timer);
+void os_timer_setfn(os_timer_t *timer, os_timer_func_t *func, void *arg);
+void os_timer_arm(os_timer_t *timer, uint32_t ms, bool repeat);
+
+#endif
@@ -0,0 +1,11 @@
+/* Host stand-in for the SDK user_interface.h, for the benchmarks. */
+#ifndef USER_INTERFACE_H
+#define USER_INTERFACE_H
+
+#include "os_type.h"
+#include "ip_addr.h"
+
+uint32 system_get_time(void);
+uint32 system_get_free_heap_size(void);
+
+#endif
@@ -0,0 +1,62 @@
+/* Host versions of the SDK and debug functions used by the code under
+ * test. Output is dropped, and memory comes from the C library. */
+#include <stdlib.h>
+#include <time.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* Stubs take the SDK parameters, and ignore most of them. */
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+volatile unsigned long bench_sink;
+unsigned long bench_allocs;
+
+int ets_printf(const char *format, ...)
+{
+	return(0);
+}
+
+void *db_alloc(size_t size, bool zero, char *info)
+{
+	if (zero)
+	{
+		return(calloc(1, size));
+	}
+	return(malloc(size));
+}
+
+void *db_realloc(void *ptr, size_t size, char *info)
+{
+	return(realloc(ptr, size));
+}
+
+void db_dealloc(void *ptr)
+{
+	free(ptr);
+}
+
+uint32 system_get_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+
+uint32 system_get_free_heap_size(void)
+{
+	return(0);
+}
+
+void os_timer_disarm(os_timer_t *timer)
+{
+}
+
+void os_timer_setfn(os_timer_t *timer, os_timer_func_t *func, void *arg)
+{
+}
+
+void os_timer_arm(os_timer_t *timer, uint32_t ms, bool repeat)
+{
+}
@@ -38,6 +38,7 @@
 #include "common.h"
 #include "dbffs.h"
 #include "dbffs-gen.h"
+#include "dbffs-mime.h"
 
 struct dbffs_file_hdr *create_file_entry(const char *path, const char *entryname)
 {
@@ -60,6 +61,7 @@ struct dbffs_file_hdr *create_file_entry(const char *path, const char *entryname
 	}
 	strcpy(entry->name, entryname);
 	entry->name_len  = strlen(entryname);
+	entry->mime = get_mime_index(entryname);
 	//Find file data length.
 	info("%s.\n", path);
 	errno = 0;
@@ -129,7 +131,8 @@ uint32_t write_file_entry(const struct dbffs_file_hdr *entry, FILE *fp)
 		//Calculate offset of the next entry.
 		offset = sizeof(entry->signature) + 4 + //signature(4) + offset(4) +
 				 sizeof(entry->name_len) + //name length(1) +
-				 entry->name_len + sizeof(entry->size) + //name_len + data_size(4) + 
+				 entry->name_len + sizeof(entry->mime) + //name_len + mime(1) +
+				 sizeof(entry->size) + //data_size(4) +
 				 entry->size; //data_size
 	}
 	else
@@ -158,6 +161,13 @@ uint32_t write_file_entry(const struct dbffs_file_hdr *entry, FILE *fp)
 	{
 		die("Could not write file name.");
 	}
+	//Write MIME-type.
+	errno = 0;
+	ret = fwrite(&entry->mime, sizeof(uint8_t), sizeof(entry->mime), fp);
+	if ((ret != sizeof(entry->mime)) || (errno > 0))
+	{
+		die("Could not write file MIME-type.");
+	}
 	//Write data size.
 	errno = 0;
 	ret = fwrite(&entry->size, sizeof(uint8_t), sizeof(entry->size), fp);
@@ -0,0 +1,56 @@
+/** 
+ * @file dbffs-mime.c
+ *
+ * @brief MIME-type index of file entries.
+ *
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include <string.h> //strrchr
+#include <strings.h> //strcasecmp
+#include <stdint.h> //Fixed width integer types.
+#include "dbffs-mime.h"
+
+/**
+ * @brief File extensions in the order of #dbffs_mime.
+ */
+static const char *mime_exts[DBFFS_N_MIME_TYPES] =
+{
+	"htm", "html", "css", "js", "json", "txt", "jpg", "jpeg", "png",
+	"ico", "gz", "svg", "woff2", "wasm", "map", "bin"
+};
+
+uint8_t get_mime_index(const char *filename)
+{
+	const char *ext;
+	uint8_t i;
+	
+	ext = strrchr(filename, '.');
+	if (!ext)
+	{
+		return(DBFFS_MIME_BIN);
+	}
+	ext++;
+	for (i = 0; i < DBFFS_N_MIME_TYPES; i++)
+	{
+		if (strcasecmp(mime_exts[i], ext) == 0)
+		{
+			return(i);
+		}
+	}
+	return(DBFFS_MIME_BIN);
+}
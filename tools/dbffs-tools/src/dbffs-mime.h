@@ -0,0 +1,63 @@
+/** 
+ * @file dbffs-mime.h
+ *
+ * @brief MIME-type index of file entries.
+ *
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#ifndef DBFFS_MIME_H
+#define DBFFS_MIME_H
+
+#include <stdint.h> //Fixed width integer types.
+
+/**
+ * @brief MIME-type indexes.
+ * 
+ * *Must match `enum http_mime_enum` in the firmware
+ * (user/slighttp/http-mime.h).*
+ */
+enum dbffs_mime
+{
+	DBFFS_MIME_HTM,
+	DBFFS_MIME_HTML,
+	DBFFS_MIME_CSS,
+	DBFFS_MIME_JS,
+	DBFFS_MIME_JSON,
+	DBFFS_MIME_TXT,
+	DBFFS_MIME_JPG,
+	DBFFS_MIME_JPEG,
+	DBFFS_MIME_PNG,
+	DBFFS_MIME_ICO,
+	DBFFS_MIME_GZIP,
+	DBFFS_MIME_SVG,
+	DBFFS_MIME_WOFF2,
+	DBFFS_MIME_WASM,
+	DBFFS_MIME_MAP,
+	DBFFS_MIME_BIN,
+	DBFFS_N_MIME_TYPES
+};
+
+/**
+ * @brief Get the MIME-type index of a file from its extension.
+ *
+ * @param filename Name of the file.
+ * @return MIME-type index, #DBFFS_MIME_BIN if the extension is unknown.
+ */
+extern uint8_t get_mime_index(const char *filename);
+
+#endif //DBFFS_MIME_H
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# Rename static assets with a hash of their content, and rewrite the
+# references in the HTML files.
+#
+# custom.css becomes custom.<hash>.css, letting the web server tell the
+# browser to cache it for good. Links to assets are renamed as well.
+# Running it again, after the original files have been copied back,
+# replaces the old fingerprinted files.
+#
+# Usage: fingerprint.py <root dir>
+#
+# 2015 Martin Grønholdt.
+import hashlib
+import os
+import re
+import sys
+
+# Extensions of the files to fingerprint.
+ASSETS = ('.css', '.js')
+# Hex digits of the hash in file names, must match HTTP_FS_HASH_SIZE.
+HASH_SIZE = 8
+
+hashed_re = re.compile(r'^(.+)\.[0-9a-f]{%d}(\.[a-z]+)$' % HASH_SIZE)
+ref_re = re.compile(r'''((?:href|src)=["'])([^"'#?]+)''')
+
+
+def is_asset(name):
+    return os.path.splitext(name)[1] in ASSETS
+
+
+def unhashed(name):
+    match = hashed_re.match(name)
+    if match:
+        return match.group(1) + match.group(2)
+    return name
+
+
+def hashed(name, digest):
+    stem, ext = os.path.splitext(name)
+    return '%s.%s%s' % (stem, digest, ext)
+
+
+def remove_old(path):
+    """Remove fingerprinted versions of a file from an earlier run."""
+    directory, name = os.path.split(path)
+    for old in os.listdir(directory):
+        if (old != name) and (unhashed(old) == name) and (old != unhashed(old)):
+            os.remove(os.path.join(directory, old))
+
+
+def key(path):
+    """Identify a file by its real directory, links are followed."""
+    directory, name = os.path.split(path)
+    return os.path.join(os.path.realpath(directory), unhashed(name))
+
+
+def rename_files(root):
+    names = dict()
+    for directory, dirs, files in os.walk(root):
+        for name in files:
+            path = os.path.join(directory, name)
+            if ((os.path.islink(path)) or (not is_asset(name)) or
+                    (unhashed(name) != name)):
+                continue
+            with open(path, 'rb') as f:
+                digest = hashlib.sha1(f.read()).hexdigest()[:HASH_SIZE]
+            remove_old(path)
+            os.rename(path, os.path.join(directory, hashed(name, digest)))
+            names[key(path)] = hashed(name, digest)
+            print('%s -> %s' % (path, names[key(path)]))
+    return names
+
+
+def rename_links(root, names):
+    for directory, dirs, files in os.walk(root):
+        for name in files:
+            path = os.path.join(directory, name)
+            if ((not os.path.islink(path)) or (not is_asset(name)) or
+                    (unhashed(name) != name)):
+                continue
+            target = os.readlink(path)
+            new_name = names.get(key(os.path.join(directory, target)))
+            if not new_name:
+                continue
+            remove_old(path)
+            os.remove(path)
+            os.symlink(os.path.join(os.path.dirname(target), new_name),
+                       os.path.join(directory, new_name))
+            names[key(path)] = new_name
+
+
+def rewrite_html(root, names):
+    def replace(match, directory):
+        ref = match.group(2)
+        if ':' in ref:
+            return match.group(0)
+        if ref.startswith('/'):
+            path = os.path.join(root, ref.lstrip('/'))
+        else:
+            path = os.path.join(directory, ref)
+        new_name = names.get(key(path))
+        if not new_name:
+            return match.group(0)
+        return match.group(1) + os.path.join(os.path.dirname(ref), new_name)
+
+    for directory, dirs, files in os.walk(root):
+        for name in files:
+            path = os.path.join(directory, name)
+            if (os.path.islink(path)) or (not name.endswith('.html')):
+                continue
+            with open(path, encoding='utf-8') as f:
+                html = f.read()
+            new_html = ref_re.sub(lambda m: replace(m, directory), html)
+            if new_html != html:
+                with open(path, 'w', encoding='utf-8') as f:
+                    f.write(new_html)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print('Usage: %s <root dir>' % sys.argv[0])
+        sys.exit(1)
+    root = sys.argv[1]
+    names = rename_files(root)
+    rename_links(root, names)
+    rewrite_html(root, names)
+
+
+if __name__ == '__main__':
+    main()
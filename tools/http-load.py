@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# Load the HTTP server with parallel connections.
+#
+# Opens a number of connections at the same time, each sending GET
+# requests one after the other, a new connection per request since the
+# server closes them. Prints the throughput, and the latency from
+# connecting until the whole response has arrived.
+#
+# Usage: http-load.py [-p port] [-c connections] [-n count] [-u uri] <host>
+#
+# 2015 Martin Grønholdt.
+import argparse
+import socket
+import sys
+import threading
+import time
+
+
+def request(host, port, uri):
+    """Send a request, and read the response until the server closes."""
+    sock = socket.create_connection((host, port), timeout=10)
+    try:
+        sock.sendall(('GET %s HTTP/1.1\r\n'
+                      'Host: %s\r\n'
+                      'Connection: close\r\n\r\n' % (uri, host)).encode())
+        data = b''
+        while True:
+            chunk = sock.recv(4096)
+            if not chunk:
+                break
+            data += chunk
+    finally:
+        sock.close()
+    status = data.split(b'\r\n', 1)[0].split(b' ')
+    if len(status) < 2 or not status[1].isdigit():
+        raise ConnectionError('No status line')
+    return int(status[1]), len(data)
+
+
+def worker(args, counter, lock, results):
+    """Send requests, until all have been sent."""
+    while True:
+        with lock:
+            if counter[0] >= args.count:
+                return
+            counter[0] += 1
+        start = time.perf_counter()
+        try:
+            status, size = request(args.host, args.port, args.uri)
+        except (OSError, ConnectionError) as e:
+            status, size = str(e), 0
+        elapsed = (time.perf_counter() - start) * 1000
+        with lock:
+            results.append((status, size, elapsed))
+
+
+def percentile(times, fraction):
+    return times[min(len(times) - 1, int(len(times) * fraction))]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure HTTP throughput with parallel connections.')
+    parser.add_argument('host')
+    parser.add_argument('-p', '--port', type=int, default=80)
+    parser.add_argument('-c', '--connections', type=int, default=4)
+    parser.add_argument('-n', '--count', type=int, default=200)
+    parser.add_argument('-u', '--uri', default='/')
+    args = parser.parse_args()
+    if args.connections < 1:
+        parser.error('connections must be at least 1')
+    if args.count < 1:
+        parser.error('count must be at least 1')
+
+    counter = [0]
+    lock = threading.Lock()
+    results = []
+    threads = [threading.Thread(target=worker,
+                                args=(args, counter, lock, results))
+               for i in range(args.connections)]
+    start = time.perf_counter()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.perf_counter() - start
+
+    statuses = {}
+    for status, size, ms in results:
+        statuses[status] = statuses.get(status, 0) + 1
+    ok = [r for r in results if r[0] == 200]
+    print('%d requests of %s, %d connections, in %.2f s:' %
+          (len(results), args.uri, args.connections, elapsed))
+    for status in sorted(statuses, key=str):
+        print('  %s: %d' % (status, statuses[status]))
+    if not ok:
+        print('No successful requests.')
+        sys.exit(1)
+    times = sorted(r[2] for r in ok)
+    print('Throughput %.1f requests/s, %.1f KiB/s.' %
+          (len(ok) / elapsed, sum(r[1] for r in ok) / 1024 / elapsed))
+    print('Latency of 200 responses in ms:')
+    print('  min %.1f  median %.1f  p95 %.1f  p99 %.1f  max %.1f' %
+          (times[0], percentile(times, 0.5), percentile(times, 0.95),
+           percentile(times, 0.99), times[-1]))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# Measure the round trip time of toggling a GPIO over the /ws/gpio
+# WebSocket.
+#
+# Sends w<gpio>=1 and w<gpio>=0 in turn, waits for the <gpio>=<state>
+# answer to each, and prints the times when done.
+#
+# Usage: ws-toggle.py [-p port] [-g gpio] [-n count] <host>
+#
+# 2015 Martin Grønholdt.
+import argparse
+import base64
+import hashlib
+import os
+import socket
+import struct
+import sys
+import time
+
+GUID = '258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+
+OP_TEXT = 0x1
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xa
+
+
+def recv_exactly(sock, size):
+    data = b''
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError('Connection closed')
+        data += chunk
+    return data
+
+
+def connect(host, port):
+    """Open the WebSocket, and check the handshake."""
+    sock = socket.create_connection((host, port), timeout=5)
+    key = base64.b64encode(os.urandom(16)).decode()
+    sock.sendall(('GET /ws/gpio HTTP/1.1\r\n'
+                  'Host: %s\r\n'
+                  'Upgrade: websocket\r\n'
+                  'Connection: Upgrade\r\n'
+                  'Sec-WebSocket-Key: %s\r\n'
+                  'Sec-WebSocket-Version: 13\r\n\r\n' % (host, key)).encode())
+    headers = b''
+    while b'\r\n\r\n' not in headers:
+        headers += recv_exactly(sock, 1)
+    lines = headers.decode('latin-1').split('\r\n')
+    if ' 101 ' not in lines[0]:
+        raise ConnectionError('Upgrade refused: %s' % lines[0])
+    accept = base64.b64encode(
+        hashlib.sha1((key + GUID).encode()).digest()).decode()
+    for line in lines[1:]:
+        name, _, value = line.partition(':')
+        if name.strip().lower() == 'sec-websocket-accept':
+            if value.strip() != accept:
+                raise ConnectionError('Bad Sec-WebSocket-Accept')
+            return sock
+    raise ConnectionError('No Sec-WebSocket-Accept')
+
+
+def send_frame(sock, opcode, payload):
+    """Send a masked frame, clients must mask."""
+    mask = os.urandom(4)
+    header = struct.pack('!B', 0x80 | opcode)
+    if len(payload) < 126:
+        header += struct.pack('!B', 0x80 | len(payload))
+    else:
+        header += struct.pack('!BH', 0x80 | 126, len(payload))
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    sock.sendall(header + mask + masked)
+
+
+def recv_frame(sock):
+    """Receive a frame, answering pings on the way."""
+    while True:
+        first, second = recv_exactly(sock, 2)
+        opcode = first & 0x0f
+        size = second & 0x7f
+        if size == 126:
+            size = struct.unpack('!H', recv_exactly(sock, 2))[0]
+        elif size == 127:
+            size = struct.unpack('!Q', recv_exactly(sock, 8))[0]
+        payload = recv_exactly(sock, size)
+        if opcode == OP_PING:
+            send_frame(sock, OP_PONG, payload)
+        elif opcode == OP_CLOSE:
+            raise ConnectionError('Closed by server')
+        elif opcode == OP_TEXT:
+            return payload.decode()
+
+
+def percentile(times, fraction):
+    return times[min(len(times) - 1, int(len(times) * fraction))]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure GPIO toggle latency over /ws/gpio.')
+    parser.add_argument('host')
+    parser.add_argument('-p', '--port', type=int, default=80)
+    parser.add_argument('-g', '--gpio', type=int, default=5)
+    parser.add_argument('-n', '--count', type=int, default=100)
+    args = parser.parse_args()
+    if args.count < 1:
+        parser.error('count must be at least 1')
+
+    try:
+        sock = connect(args.host, args.port)
+    except (OSError, ConnectionError) as e:
+        print('Could not connect: %s' % e)
+        sys.exit(1)
+    times = []
+    try:
+        for i in range(args.count):
+            state = (i + 1) % 2
+            message = 'w%d=%d' % (args.gpio, state)
+            expected = '%d=%d' % (args.gpio, state)
+            start = time.perf_counter()
+            send_frame(sock, OP_TEXT, message.encode())
+            answer = recv_frame(sock)
+            times.append((time.perf_counter() - start) * 1000)
+            if answer != expected:
+                print('Unexpected answer to %s: %s' % (message, answer))
+                sys.exit(1)
+        send_frame(sock, OP_CLOSE, b'')
+    except (OSError, ConnectionError) as e:
+        print('Failed after %d toggles: %s' % (len(times), e))
+        sys.exit(1)
+    finally:
+        sock.close()
+
+    times.sort()
+    print('%d toggles of GPIO %d, round trip in ms:' % (len(times), args.gpio))
+    print('  min %.1f  median %.1f  p95 %.1f  max %.1f  mean %.1f' %
+          (times[0], percentile(times, 0.5), percentile(times, 0.95),
+           times[-1], sum(times) / len(times)))
+
+
+if __name__ == '__main__':
+    main()
@@ -28,7 +28,7 @@
 /**
  * @brief DBFFS version.
  */
-#define DBFFS_VERSION "0.1.0"
+#define DBFFS_VERSION "0.2.0"
 
 /**
  * @brief File system signature.
@@ -63,6 +63,12 @@
  * @brief Maximum entries in file system. 
  */
 #define DBFFS_MAX_ENTRIES 65536
+/**
+ * @brief MIME-type index of files with an unknown type.
+ * 
+ * Other values are indexes in the MIME-type table of the firmware.
+ */
+#define DBFFS_MIME_UNKNOWN 0xFF
 
 /**
  * @brief Generic header part.
@@ -108,6 +114,10 @@ struct dbffs_file_hdr
 	 * @brief File name.
 	 */
 	char *name;
+	/**
+	 * @brief MIME-type index, see #DBFFS_MIME_UNKNOWN.
+	 */
+	uint8_t mime;
 	/**
 	 * @brief Size of file data.
 	 */
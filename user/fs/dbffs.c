@@ -133,6 +133,13 @@ static struct dbffs_file_hdr *load_file_header(unsigned int address, void *heade
 	ret = (struct dbffs_file_hdr *)load_generic_header(address, header);
 	offset += 9;
 	offset += ret->name_len;
+	if (!aflash_read(&ret->mime, offset, sizeof(ret->mime)))
+    {
+        debug("Could not read MIME-type at 0x%x.\n", offset);
+        dbffs_free_file_header(ret);
+        return(NULL);
+	}
+	offset += sizeof(ret->mime);
 	if (!aflash_read(&ret->size, offset, sizeof(ret->size)))
     {
         debug("Could not read data size at 0x%x.\n", offset);
@@ -45,6 +45,10 @@ struct fs_file
      * @brief Size of the file data.
      */
     size_t size;
+    /**
+     * @brief MIME-type index from the file header.
+     */
+    unsigned char mime;
     /**
      * @brief Set on end of file.
      */
@@ -59,14 +63,33 @@ static struct fs_file *fs_open_files[FS_MAX_OPEN_FILES];
  * @brief Number currently open files.
  */
 static FS_FILE_H n_open_files = 0;
+/**
+ * @brief Incremented every time the file system is (re)loaded.
+ */
+static unsigned long fs_gen = 0;
 
 /**
  * @brief Initialise stuff for file system access.
+ * 
+ * Call again if the file system image has been changed.
  */
 void fs_init(void)
 {
 	db_printf("ROM size %d KiB.\n", flash_size() >> 10);
 	init_dbffs();
+	fs_gen++;
+}
+
+/**
+ * @brief Get the generation of the file system image.
+ * 
+ * Data cached from the file system is stale if this has changed.
+ * 
+ * @return The generation.
+ */
+unsigned long fs_generation(void)
+{
+	return(fs_gen);
 }
 
 /**
@@ -145,6 +168,7 @@ FS_FILE_H fs_open(char *filename)
     file->pos = 0;
     file->start_pos = file_hdr->data_addr;
     file->size = file_hdr->size;
+    file->mime = file_hdr->mime;
     file->eof = false;
     
     //Free up the file header, since we don't need it anymore.
@@ -330,6 +354,22 @@ long fs_size( FS_FILE_H handle)
     return(fs_open_files[handle]->size);
 }
 
+/**
+ * @brief Get the MIME-type index stored with the file.
+ * 
+ * @param handle Handle to a file.
+ * @return MIME-type index or #DBFFS_MIME_UNKNOWN.
+ */
+unsigned char fs_mime(FS_FILE_H handle)
+{
+    if (!fs_test_handle(handle))
+    {
+        return(DBFFS_MIME_UNKNOWN);
+    }
+    
+    return(fs_open_files[handle]->mime);
+}
+
 /**
  * @brief Set the current position in the file.
  * 
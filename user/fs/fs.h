@@ -57,6 +57,7 @@ typedef enum fs_seek_pos_e fs_seek_pos_t;
 typedef int FS_FILE_H;
 
 extern void fs_init(void);
+extern unsigned long fs_generation(void);
 extern FS_FILE_H fs_open(char *filename);
 extern void fs_close(FS_FILE_H handle);
 extern size_t fs_read(void *buffer, size_t size, size_t count, FS_FILE_H handle);
@@ -64,6 +65,7 @@ extern int fs_getc(FS_FILE_H handle);
 extern char *fs_gets(char *str, size_t count, FS_FILE_H handle);
 extern long fs_tell(FS_FILE_H handle);
 extern long fs_size(FS_FILE_H handle);
+extern unsigned char fs_mime(FS_FILE_H handle);
 extern int fs_seek(FS_FILE_H handle, long offset, fs_seek_pos_t origin);
 extern int fs_eof(FS_FILE_H handle);
 
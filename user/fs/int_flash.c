@@ -102,7 +102,7 @@ void flash_dump_mem(unsigned int src_addr, size_t size)
  * @param len Bytes to copy.
  * @return Bytes actually copied.
  */
-static size_t amemcpy(unsigned char *d, unsigned char *s, size_t len)
+size_t amemcpy(unsigned char *d, unsigned char *s, size_t len)
 {
 	unsigned int i;
 	unsigned int temp;
@@ -66,6 +66,15 @@ extern void flash_dump(unsigned int src_addr, size_t size);
  * @param size Number of bytes to dump.
  */
 extern void flash_dump_mem(unsigned int src_addr, size_t size);
+/**
+ * @brief Copy memory mapped flash data using aligned reads.
+ * 
+ * @param d Destination.
+ * @param s Source.
+ * @param len Bytes to copy.
+ * @return Bytes actually copied.
+ */
+extern size_t amemcpy(unsigned char *d, unsigned char *s, size_t len);
 /**
  * @brief Read data from an arbitrary position in the FS portion of the flash.
  * 
@@ -0,0 +1,194 @@
+/** @file http-fs-cache.c
+ *
+ * @brief Cache of small rendered file system responses.
+ *
+ * Keeps complete responses for small files in RAM, so that they are
+ * served without reading the file system. The least recently used
+ * entries are dropped when the cache is full, and everything is
+ * dropped when the file system image changes.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "osapi.h"
+#include "c_types.h"
+#include "user_config.h"
+#include "fs/fs.h"
+#include "slighttp/http.h"
+#include "handlers/fs/http-fs-cache.h"
+
+/**
+ * @brief Cache statistics.
+ */
+struct http_fs_cache_stats http_fs_cache_counters;
+
+/**
+ * @brief Most recently used entry.
+ */
+static struct http_fs_cache_entry *cache_first = NULL;
+
+/**
+ * @brief File system generation of the cached responses.
+ */
+static unsigned long cache_generation = 0;
+
+/**
+ * @brief Unlink and free an entry.
+ * 
+ * @param prev The entry before the one to drop, or NULL if it is first.
+ * @param entry The entry to drop.
+ */
+static void drop_entry(struct http_fs_cache_entry *prev,
+					   struct http_fs_cache_entry *entry)
+{
+	debug("Dropping cached response for %s.\n", entry->filename);
+	if (prev)
+	{
+		prev->next = entry->next;
+	}
+	else
+	{
+		cache_first = entry->next;
+	}
+	http_fs_cache_counters.entries--;
+	http_fs_cache_counters.used -= sizeof(struct http_fs_cache_entry) +
+								   os_strlen(entry->filename) + 1 +
+								   entry->size;
+	db_free(entry);
+}
+
+/**
+ * @brief Drop all entries if the file system image has changed.
+ */
+static void check_generation(void)
+{
+	if (cache_generation != fs_generation())
+	{
+		debug("File system changed, dropping cached responses.\n");
+		while (cache_first)
+		{
+			drop_entry(NULL, cache_first);
+		}
+		cache_generation = fs_generation();
+	}
+}
+
+/**
+ * @brief Find a cached response.
+ * 
+ * A found entry is valid until the next call to http_fs_cache_add().
+ * 
+ * @param filename Name of the file in the file system.
+ * @param status_code Status code of the response.
+ * @return The entry or NULL if the response is not cached.
+ */
+struct http_fs_cache_entry *http_fs_cache_find(char *filename,
+											   unsigned short status_code)
+{
+	struct http_fs_cache_entry *entry;
+	struct http_fs_cache_entry *prev = NULL;
+	
+	check_generation();
+	for (entry = cache_first; entry; entry = entry->next)
+	{
+		if ((entry->status_code == status_code) &&
+			(os_strcmp(entry->filename, filename) == 0))
+		{
+			debug("Cached response for %s.\n", filename);
+			//Move to front.
+			if (prev)
+			{
+				prev->next = entry->next;
+				entry->next = cache_first;
+				cache_first = entry;
+			}
+			http_fs_cache_counters.hits++;
+			return(entry);
+		}
+		prev = entry;
+	}
+	http_fs_cache_counters.misses++;
+	return(NULL);
+}
+
+/**
+ * @brief Add a rendered response to the cache.
+ * 
+ * Least recently used entries are dropped to make room.
+ * 
+ * @param filename Name of the file in the file system.
+ * @param status_code Status code of the response.
+ * @param data The response.
+ * @param size Size of the response.
+ * @param header_size Size of the status-line and headers in the response.
+ * @return True if the response was cached.
+ */
+bool http_fs_cache_add(char *filename, unsigned short status_code,
+					   char *data, size_t size, size_t header_size)
+{
+	struct http_fs_cache_entry *entry;
+	struct http_fs_cache_entry *prev;
+	size_t filename_size;
+	size_t entry_size;
+	
+	if ((size > HTTP_FS_CACHE_MAX_RESPONSE) || (size > HTTP_SEND_BUFFER_SIZE))
+	{
+		debug("Response for %s too large to cache.\n", filename);
+		return(false);
+	}
+	check_generation();
+	filename_size = os_strlen(filename) + 1;
+	entry_size = sizeof(struct http_fs_cache_entry) + filename_size + size;
+	if (entry_size > HTTP_FS_CACHE_SIZE)
+	{
+		return(false);
+	}
+	//Make room.
+	while (cache_first &&
+		   (http_fs_cache_counters.used + entry_size > HTTP_FS_CACHE_SIZE))
+	{
+		prev = NULL;
+		for (entry = cache_first; entry->next; entry = entry->next)
+		{
+			prev = entry;
+		}
+		drop_entry(prev, entry);
+	}
+	
+	entry = db_malloc(entry_size, "http_fs_cache_add entry");
+	if (!entry)
+	{
+		warn("Could not allocate memory for cached response.\n");
+		return(false);
+	}
+	debug("Caching %d bytes response for %s.\n", size, filename);
+	entry->filename = (char *)(entry + 1);
+	os_memcpy(entry->filename, filename, filename_size);
+	entry->data = entry->filename + filename_size;
+	os_memcpy(entry->data, data, size);
+	entry->status_code = status_code;
+	entry->header_size = header_size;
+	entry->size = size;
+	entry->next = cache_first;
+	cache_first = entry;
+	http_fs_cache_counters.entries++;
+	http_fs_cache_counters.used += entry_size;
+	
+	return(true);
+}
@@ -0,0 +1,106 @@
+/** @file http-fs-cache.h
+ *
+ * @brief Cache of small rendered file system responses.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */ 
+#ifndef HTTP_FS_CACHE_H
+#define HTTP_FS_CACHE_H
+
+#include "c_types.h"
+
+#ifndef HTTP_FS_CACHE_SIZE
+/**
+ * @brief Bytes of heap the cache may use.
+ */
+#define HTTP_FS_CACHE_SIZE 4096
+#endif
+
+#ifndef HTTP_FS_CACHE_MAX_RESPONSE
+/**
+ * @brief Largest response (status, headers, and body) that is cached.
+ * 
+ * Must not be larger than #HTTP_SEND_BUFFER_SIZE.
+ */
+#define HTTP_FS_CACHE_MAX_RESPONSE 1024
+#endif
+
+/**
+ * @brief A rendered response.
+ */
+struct http_fs_cache_entry
+{
+	/**
+	 * @brief Name of the file in the file system.
+	 */
+	char *filename;
+	/**
+	 * @brief Status code of the response.
+	 */
+	unsigned short status_code;
+	/**
+	 * @brief Size of the status-line and headers.
+	 */
+	size_t header_size;
+	/**
+	 * @brief Size of the whole response.
+	 */
+	size_t size;
+	/**
+	 * @brief The response.
+	 */
+	char *data;
+	/**
+	 * @brief Next entry, in order of last use.
+	 */
+	struct http_fs_cache_entry *next;
+};
+
+/**
+ * @brief Cache statistics.
+ */
+struct http_fs_cache_stats
+{
+	/**
+	 * @brief Responses served from the cache.
+	 */
+	unsigned long hits;
+	/**
+	 * @brief Responses not found in the cache.
+	 */
+	unsigned long misses;
+	/**
+	 * @brief Number of entries.
+	 */
+	unsigned short entries;
+	/**
+	 * @brief Heap used by the entries.
+	 */
+	size_t used;
+};
+
+extern struct http_fs_cache_stats http_fs_cache_counters;
+
+extern struct http_fs_cache_entry *http_fs_cache_find(char *filename,
+	unsigned short status_code);
+extern bool http_fs_cache_add(char *filename, unsigned short status_code,
+	char *data, size_t size, size_t header_size);
+
+#endif //HTTP_FS_CACHE_H
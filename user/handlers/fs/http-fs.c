@@ -31,13 +31,24 @@
 #include "user_interface.h"
 #include "user_config.h"
 #include "fs/fs.h"
+#include "fs/dbffs.h"
 #include "tools/strxtra.h"
 #include "slighttp/http.h"
 #include "slighttp/http-mime.h"
 #include "handlers/fs/http-fs.h"
+#include "handlers/fs/http-fs-cache.h"
 #include "slighttp/http-handler.h"
 #include "slighttp/http-response.h"
 
+/**
+ * @brief Header for files, whose names change with their content.
+ */
+#define HTTP_FS_CACHE_IMMUTABLE "Cache-Control: public, max-age=31536000, immutable\r\n"
+/**
+ * @brief Header for HTML, that must be checked every time.
+ */
+#define HTTP_FS_CACHE_NO_CACHE "Cache-Control: no-cache\r\n"
+
 /**
  * @brief Root to use when searching the fs.
  */
@@ -59,6 +70,10 @@ struct http_fs_context
 	 * @brief The file.
 	 */
 	FS_FILE_H file;
+	/**
+	 * @brief Cached response, if the file has not been opened.
+	 */
+	struct http_fs_cache_entry *cached;
 };
 
 /**
@@ -121,7 +136,13 @@ static bool http_fs_open_file(struct http_request *request, bool err)
 	if ((err) && (request->response.status_code > 399))
 	{
 		debug(" Error status %d.\n", request->response.status_code);
-		uri = db_malloc(sizeof(char) * 10, "uri http_fs_open_file");
+		uri = arena_alloc(&request->arena, sizeof(char) * 10);
+		if (!uri)
+		{
+			error("Could not allocate memory for the error page name.\n");
+			request->response.status_code = 500;
+			return(false);
+		}
 		uri[0] = '/';
 		itoa(request->response.status_code, uri + 1, 10);
 		os_memcpy(uri + 4, ".html\0", 6);
@@ -150,8 +171,17 @@ static bool http_fs_open_file(struct http_request *request, bool err)
 		}
 		
 		//Get size and mem.
-		fs_uri = db_zalloc(root_size + uri_size + index_size + 1,
-						   "fs_uri http_fs_open_file");
+		fs_uri = arena_alloc(&request->arena,
+							 root_size + uri_size + index_size + 1);
+		//Save file name in context.
+		context = arena_alloc(&request->arena, sizeof(struct http_fs_context));
+		if ((!fs_uri) || (!context))
+		{
+			error("Could not allocate memory for the file name.\n");
+			request->response.status_code = 500;
+			return(false);
+		}
+		fs_uri[0] = '\0';
 		
 		if (root_size)
 		{
@@ -167,16 +197,8 @@ static bool http_fs_open_file(struct http_request *request, bool err)
 			debug(" Added index.html URI %s.\n", fs_uri);
 		}
 		
-		//Save file name in context.
-		context = db_malloc(sizeof(struct http_fs_context), "context http_fs_open_file");
 		context->filename = fs_uri;
 		request->response.context = context;
-		
-		//Free URI if needed.
-		if (request->response.status_code > 399)
-		{
-			db_free(--uri);
-		}
 	}
 	else
 	{
@@ -184,6 +206,14 @@ static bool http_fs_open_file(struct http_request *request, bool err)
 		context = request->response.context;
 	}
 	
+	//Use the cached response if there is one.
+	context->cached = http_fs_cache_find(context->filename,
+										 request->response.status_code);
+	if (context->cached)
+	{
+		return(true);
+	}
+	
 	//Try opening the URI as a file.
     context->file = fs_open(context->filename);
    	if (context->file > FS_EOF)
@@ -193,17 +223,89 @@ static bool http_fs_open_file(struct http_request *request, bool err)
 		debug("File found: %s.\n", context->filename);
 		return(true);
 	}
-	//Free context if there is an error, and we are not handling it.
+	//Drop context if there is an error, and we are not handling it.
 	if (!err)
 	{
-		debug(" Error status, freeing context.\n");
-		db_free(context);
+		debug(" Error status, dropping context.\n");
 		request->response.context = NULL;
 	}
 	debug("File not found: %s.\n", context->filename);
     return(false);
 }
 
+/**
+ * @brief Check if a file name has a content hash.
+ * 
+ * Fingerprinted names look like `custom.<hash>.css`, where the hash is
+ * #HTTP_FS_HASH_SIZE lower case hex digits.
+ * 
+ * @param filename The file name.
+ * @return True if the name has a hash.
+ */
+static bool fingerprinted(const char *filename)
+{
+	const char *ext = NULL;
+	const char *pos;
+	unsigned char i;
+	
+	//Find the extension.
+	for (pos = filename; *pos; pos++)
+	{
+		if (*pos == '.')
+		{
+			ext = pos;
+		}
+	}
+	if ((!ext) || ((ext - filename) < (HTTP_FS_HASH_SIZE + 2)))
+	{
+		return(false);
+	}
+	//The hash is between the extension and the dot before it.
+	pos = ext - HTTP_FS_HASH_SIZE;
+	if (*(pos - 1) != '.')
+	{
+		return(false);
+	}
+	for (i = 0; i < HTTP_FS_HASH_SIZE; i++)
+	{
+		if (!(((pos[i] >= '0') && (pos[i] <= '9')) ||
+			  ((pos[i] >= 'a') && (pos[i] <= 'f'))))
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
+
+/**
+ * @brief Send the Cache-Control header of a file.
+ * 
+ * Fingerprinted files never change, and are cached for a year. HTML
+ * is checked every time, since it names the fingerprinted files.
+ * 
+ * @param request The request.
+ * @param mime MIME type of the file.
+ * @return Bytes sent.
+ */
+static size_t send_cache_control(struct http_request *request,
+								 unsigned char mime)
+{
+	struct http_fs_context *context = request->response.context;
+	
+	if ((request->response.status_code == 200) &&
+		(fingerprinted(context->filename)))
+	{
+		return(http_send_ref(request->connection, HTTP_FS_CACHE_IMMUTABLE,
+							 HTTP_CONST_SIZE(HTTP_FS_CACHE_IMMUTABLE)));
+	}
+	if ((mime == MIME_HTM) || (mime == MIME_HTML))
+	{
+		return(http_send_ref(request->connection, HTTP_FS_CACHE_NO_CACHE,
+							 HTTP_CONST_SIZE(HTTP_FS_CACHE_NO_CACHE)));
+	}
+	return(0);
+}
+
 /**
  * @brief Send a file.
  * 
@@ -222,10 +324,10 @@ static signed int do_message(struct http_request *request, bool err)
 	 * pass a NULL pointer ;).
 	 */
 	struct http_fs_context *context = request->response.context;
-	size_t data_left, buffer_free, bytes;
-	char buffer[HTTP_FILE_CHUNK_SIZE];
+	size_t data_left, buffer_free, bytes, size;
 	signed int ret = 0;
-	char *ext;
+	unsigned char mime;
+	char *start;
 	
 	//Status and headers.
 	if (request->response.state == HTTP_STATE_NONE)
@@ -239,11 +341,29 @@ static signed int do_message(struct http_request *request, bool err)
 		context = request->response.context;
 		//We have not send anything.
 		request->response.message_size = 0;
-		//Get extension.
-		ext = http_mime_get_ext(context->filename);
+		if (context->cached)
+		{
+			size = context->cached->size;
+			if (request->type == HTTP_HEAD)
+			{
+				size = context->cached->header_size;
+			}
+			ret = http_send(request->connection, context->cached->data, size);
+			request->response.message_size = size - context->cached->header_size;
+			request->response.state = HTTP_STATE_DONE;
+			return(ret);
+		}
+		//The image stores the MIME-type, look it up if it is unknown.
+		mime = fs_mime(context->file);
+		if (mime == DBFFS_MIME_UNKNOWN)
+		{
+			mime = http_mime_lookup(http_mime_get_ext(context->filename));
+		}
 		//Send status and headers.
+		start = request->response.send_buffer_pos;
 		ret += http_send_status_line(request->connection, request->response.status_code);
-		ret += http_send_default_headers(request, context->total_size, ext);
+		ret += send_cache_control(request, mime);
+		ret += http_send_default_headers(request, context->total_size, mime);
 		if (request->type == HTTP_HEAD)
 		{
 			request->response.state = HTTP_STATE_DONE;
@@ -253,6 +373,20 @@ static signed int do_message(struct http_request *request, bool err)
 		{
 			//Go on to sending the file.
 			request->response.state = HTTP_STATE_MESSAGE;
+			//Render small files in one go, and cache the response.
+			size = ret + context->total_size;
+			if ((size <= HTTP_FS_CACHE_MAX_RESPONSE) &&
+				(start + size <= request->response.send_buffer + HTTP_SEND_BUFFER_SIZE))
+			{
+				ret += http_send_file(request->connection, context->file,
+									  context->total_size);
+				request->response.message_size = context->total_size;
+				http_fill_segments(request);
+				http_fs_cache_add(context->filename,
+								  request->response.status_code, start,
+								  ret, ret - context->total_size);
+				return(ret);
+			}
 		}
 	}
 	
@@ -291,8 +425,8 @@ static signed int do_message(struct http_request *request, bool err)
 		}
 		if (bytes)
 		{
-			fs_read(buffer, bytes, sizeof(char), context->file);
-			ret += http_send(request->connection, buffer, bytes);
+			//Read directly into the send buffer, when sending.
+			ret += http_send_file(request->connection, context->file, bytes);
 			request->response.message_size += bytes;
 			//Might send status and header data as well.
 			if (ret >= bytes)
@@ -316,19 +450,12 @@ static signed int do_message(struct http_request *request, bool err)
 		{
 			warn("Did not sent full message.\n");
 		}
-		fs_close(context->file);
-		debug("Freeing data for file response.\n");
-		if (context)
+		if (!context->cached)
 		{
-			if (context->filename)
-			{
-				debug("Deallocating file name %s.\n", context->filename);
-				db_free(context->filename);
-			}
-			debug("Deallocating request handler context.\n");
-			db_free(context);
-			request->response.context = NULL;
+			fs_close(context->file);
 		}
+		//The context is in the request arena.
+		request->response.context = NULL;
 	}
 	debug("Response done.\n");
 	return(RESPONSE_DONE_FINAL);
@@ -337,7 +464,8 @@ static signed int do_message(struct http_request *request, bool err)
 /**
  * @brief Handle HTTP file system responses.
  * 
- * Does nothing if an error status is set.
+ * Does nothing if an error status is set. Only register this for
+ * #HTTP_METHODS_GET.
  */
 signed int http_fs_handler(struct http_request *request)
 {	
@@ -356,12 +484,6 @@ signed int http_fs_handler(struct http_request *request)
 			  request->response.status_code);
 		return(RESPONSE_DONE_CONTINUE);
 	}
-	if ((request->type != HTTP_GET) &&
-		(request->type != HTTP_HEAD))
-	{
-		debug(" File system handler only supports GET.\n");
-		return(RESPONSE_DONE_CONTINUE);
-	}
 	
 	return(do_message(request, false));
 }
@@ -26,6 +26,15 @@
 
 #include "slighttp/http.h"
 
+#ifndef HTTP_FS_HASH_SIZE
+/**
+ * @brief Hex digits of the content hash in fingerprinted file names.
+ * 
+ * Must match `HASH_SIZE` in `tools/fingerprint.py`.
+ */
+#define HTTP_FS_HASH_SIZE 8
+#endif
+
 extern bool http_fs_init(char *root);
 extern signed int http_fs_handler(struct http_request *request);
 extern signed int http_fs_error_handler(struct http_request *request);
@@ -0,0 +1,336 @@
+/**
+ * @file batch.c
+ *
+ * @brief REST interface for running several REST requests at once.
+ * 
+ * A PUT request to `/rest/batch` with a JSON array of operations, like:
+ * 
+ *     [{"method":"GET","uri":"/rest/fw/mem"},
+ *      {"method":"PUT","uri":"/rest/gpios/5","body":{"state":1}}]
+ * 
+ * runs each operation through the GET or PUT callback of its route, and
+ * answers with an array of the results in the same order:
+ * 
+ *     [{"status":200,"body":{"free":21432,...}},{"status":204}]
+ * 
+ * The method defaults to GET. Only routes with per method callbacks can
+ * be used. Every operation is checked before any of them is run, so a
+ * malformed batch is answered with 400, and has no effect.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "osapi.h"
+#include "c_types.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "tools/json-decode.h"
+#include "tools/json-writer.h"
+#include "slighttp/http.h"
+#include "slighttp/http-common.h"
+#include "slighttp/http-handler.h"
+#include "handlers/rest/rest.h"
+
+#ifndef REST_BATCH_OPERATIONS
+/**
+ * @brief Maximum number of operations in a batch.
+ */
+#define REST_BATCH_OPERATIONS 8
+#endif
+
+/**
+ * @brief An operation of the batch.
+ */
+struct rest_batch_operation
+{
+	/**
+	 * @brief Request type of the operation.
+	 */
+	enum request_types type;
+	/**
+	 * @brief Buffer for the URI.
+	 */
+	char *uri;
+	/**
+	 * @brief Buffer for the message body.
+	 */
+	char *body;
+	/**
+	 * @brief Size of each buffer.
+	 */
+	size_t size;
+	/**
+	 * @brief The message body, or NULL if there is none.
+	 */
+	char *message;
+};
+
+/**
+ * @brief Read an operation object.
+ * 
+ * @param json The JSON of the object.
+ * @param size Size of the JSON.
+ * @param operation The operation, with buffers at least as large as the
+ *                  JSON.
+ * @return True on success, false if the operation is malformed.
+ */
+static bool read_operation(const char *json, size_t size,
+						   struct rest_batch_operation *operation)
+{
+	char method[4];
+	const struct json_field fields[] =
+	{
+		{ "method", JSON_FIELD_STRING, method, sizeof(method) },
+		{ "uri", JSON_FIELD_STRING, operation->uri, operation->size },
+		{ "body", JSON_FIELD_RAW, operation->body, operation->size }
+	};
+	signed int found;
+	
+	found = json_decode(json, size, fields, 3);
+	if ((found == JSON_DECODE_ERROR) || (!JSON_FOUND(found, 1)))
+	{
+		return(false);
+	}
+	operation->type = HTTP_GET;
+	if (JSON_FOUND(found, 0))
+	{
+		if (os_strcmp(method, "PUT") == 0)
+		{
+			operation->type = HTTP_PUT;
+		}
+		else if (os_strcmp(method, "GET") != 0)
+		{
+			return(false);
+		}
+	}
+	operation->message = NULL;
+	if (JSON_FOUND(found, 2))
+	{
+		operation->message = operation->body;
+	}
+	return(true);
+}
+
+/**
+ * @brief Run an operation through the callbacks of its route.
+ * 
+ * Routes are tried in order, like for a request of its own, until one
+ * creates a response.
+ * 
+ * @param sub The request used for the operation.
+ * @param operation The operation.
+ * @return Status code.
+ */
+static unsigned short run_operation(struct http_request *sub,
+									struct rest_batch_operation *operation)
+{
+	const struct http_method_handlers *callbacks;
+	http_handler_callback callback;
+	signed int ret;
+	
+	debug("Batch %s %s.\n", http_method_names[operation->type],
+		  operation->uri);
+	sub->type = operation->type;
+	sub->uri = operation->uri;
+	sub->message = operation->message;
+	sub->response.status_code = 200;
+	sub->response.message = NULL;
+	sub->response.context = NULL;
+	sub->response.allow = 0;
+	
+	http_get_handler(sub, NULL);
+	while ((sub->response.route) && (sub->response.route->callbacks))
+	{
+		callbacks = sub->response.route->callbacks;
+		//No batches in batches.
+		if (callbacks == &http_rest_batch_methods)
+		{
+			return(400);
+		}
+		callback = (sub->type == HTTP_PUT) ? callbacks->put : callbacks->get;
+		ret = callback(sub);
+		if ((ret == RESPONSE_DONE_ERROR) && (sub->response.status_code < 400))
+		{
+			sub->response.status_code = 500;
+		}
+		if (ret != RESPONSE_DONE_CONTINUE)
+		{
+			if (callbacks->free)
+			{
+				callbacks->free(sub);
+			}
+			if (sub->response.context)
+			{
+				db_free(sub->response.context);
+				sub->response.context = NULL;
+			}
+			if ((ret == 0) && (sub->response.status_code == 200))
+			{
+				return(204);
+			}
+			return(sub->response.status_code);
+		}
+		http_get_handler(sub, sub->response.route);
+	}
+	//What is left is not REST.
+	if (sub->response.status_code < 400)
+	{
+		return(404);
+	}
+	return(sub->response.status_code);
+}
+
+/**
+ * @brief Write the results of the operations.
+ * 
+ * @param writer The JSON writer.
+ * @param status Status code of each operation.
+ * @param bodies Response body of each operation, or NULL.
+ * @param n_operations Number of operations.
+ * @return Size of the JSON.
+ */
+static size_t write_results(struct json_writer *writer, unsigned short *status,
+							char **bodies, unsigned char n_operations)
+{
+	unsigned char i;
+	
+	json_begin_array(writer);
+	for (i = 0; i < n_operations; i++)
+	{
+		json_begin_object(writer);
+		json_key(writer, "status");
+		json_number(writer, status[i]);
+		if (bodies[i])
+		{
+			json_key(writer, "body");
+			json_raw(writer, bodies[i], os_strlen(bodies[i]));
+		}
+		json_end_object(writer);
+	}
+	json_end_array(writer);
+	return(json_writer_size(writer));
+}
+
+/**
+ * @brief Run the batch, and create the response.
+ * 
+ * @param request Request to respond to.
+ * @return Size of the response.
+ */
+static signed int create_put_response(struct http_request *request)
+{
+	struct rest_batch_operation operation;
+	struct json_array array;
+	struct json_writer writer;
+	struct http_request *sub;
+	unsigned short status[REST_BATCH_OPERATIONS];
+	char *bodies[REST_BATCH_OPERATIONS];
+	const char *element;
+	signed int element_size;
+	size_t size;
+	unsigned char n_operations = 0;
+	unsigned char i;
+	
+	debug("Creating batch REST response.\n");
+	if (!request->message)
+	{
+		request->response.status_code = 400;
+		return(RESPONSE_DONE_ERROR);
+	}
+	//No value in the batch is larger than the batch itself.
+	size = os_strlen(request->message);
+	operation.size = size + 1;
+	operation.uri = arena_alloc(&request->arena, operation.size * 2);
+	if (!operation.uri)
+	{
+		error("Could not allocate memory for batch.\n");
+		request->response.status_code = 500;
+		return(RESPONSE_DONE_ERROR);
+	}
+	operation.body = operation.uri + operation.size;
+	
+	//Check every operation, before running any of them.
+	element_size = JSON_DECODE_ERROR;
+	if (json_array_begin(&array, request->message, size))
+	{
+		while ((element_size = json_array_next(&array, &element)) > 0)
+		{
+			if ((++n_operations > REST_BATCH_OPERATIONS) ||
+				(!read_operation(element, element_size, &operation)))
+			{
+				element_size = JSON_DECODE_ERROR;
+				break;
+			}
+		}
+	}
+	if ((element_size < 0) || (!n_operations))
+	{
+		warn("Bad batch, or too many operations.\n");
+		request->response.status_code = 400;
+		return(RESPONSE_DONE_ERROR);
+	}
+	
+	sub = db_zalloc(sizeof(struct http_request), "sub create_put_response");
+	if (!sub)
+	{
+		error("Could not allocate memory for batch.\n");
+		request->response.status_code = 500;
+		return(RESPONSE_DONE_ERROR);
+	}
+	sub->connection = request->connection;
+	json_array_begin(&array, request->message, size);
+	for (i = 0; i < n_operations; i++)
+	{
+		element_size = json_array_next(&array, &element);
+		read_operation(element, element_size, &operation);
+		status[i] = run_operation(sub, &operation);
+		bodies[i] = sub->response.message;
+	}
+	db_free(sub);
+	
+	json_writer_init(&writer, NULL, 0);
+	size = write_results(&writer, status, bodies, n_operations);
+	request->response.message = db_malloc(size + 1, "request->response.message create_put_response");
+	if (request->response.message)
+	{
+		json_writer_init(&writer, request->response.message, size + 1);
+		write_results(&writer, status, bodies, n_operations);
+	}
+	for (i = 0; i < n_operations; i++)
+	{
+		db_free(bodies[i]);
+	}
+	if (!request->response.message)
+	{
+		error("Could not allocate memory for batch results.\n");
+		request->response.status_code = 500;
+		return(RESPONSE_DONE_ERROR);
+	}
+	return(size);
+}
+
+/**
+ * @brief REST callbacks for batches.
+ */
+const struct http_method_handlers http_rest_batch_methods =
+{
+	.get = NULL,
+	.put = create_put_response,
+	.free = NULL
+};
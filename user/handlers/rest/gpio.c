@@ -37,12 +37,14 @@
 #include "gpio.h"
 #include "user_interface.h"
 #include "user_config.h"
-#include "tools/jsmn.h"
+#include "tools/json-decode.h"
 #include "tools/json-gen.h"
 #include "slighttp/http.h"
 #include "slighttp/http-mime.h"
 #include "slighttp/http-response.h"
 #include "slighttp/http-handler.h"
+#include "slighttp/http-sse.h"
+#include "slighttp/http-ws.h"
 #include "tools/strxtra.h"
 #include "user_config.h"
 
@@ -59,7 +61,7 @@
  */
 #define REST_GPIO_PINS 16
 /**
- * @brief GPIO were are working with or -1 if no specific pin.
+ * @brief GPIO were are working with.
  */
 static signed char current_gpio = -1;
 
@@ -124,134 +126,238 @@ static signed int create_pin_response(struct http_request *request)
 }
 
 /**
- * @brief Create the GET response.
+ * @brief Check if a GPIO may be used via the REST interface.
  * 
- * @param request Request to respond to..
- * @return Size of the response.
+ * @param gpio The GPIO.
+ * @return True if the GPIO is enabled.
  */
-static signed int create_get_response(struct http_request *request)
+static bool pin_enabled(signed int gpio)
+{
+	return((gpio >= 0) && (gpio < REST_GPIO_PINS) &&
+		   (((REST_GPIO_ENABLED >> gpio) & 1) == 1));
+}
+
+/**
+ * @brief Send the state of a GPIO to the event streams and WebSockets.
+ * 
+ * Called whenever an output is changed.
+ * 
+ * @param gpio The GPIO that has changed.
+ */
+void http_rest_gpio_notify(unsigned char gpio)
 {
-	signed int ret;
+	char json[24];
+	char msg[6];
+	unsigned char state = GPIO_INPUT_GET(gpio);
 	
-    debug("Creating GPIO REST GET response.\n");
-	if (current_gpio < 0)
-	{
-		ret = create_enabled_response(request);
-	}
-	else
-	{
-		ret = create_pin_response(request);
-	}
-	return(ret);
+	os_sprintf(json, "{\"gpio\":%d,\"state\":%d}", gpio, state);
+	http_sse_send("gpio", json);
+	http_ws_broadcast(msg, os_sprintf(msg, "%d=%d", gpio, state));
 }
 
 /**
- * @brief Create PUT response.
+ * @brief Send the state of a GPIO on a WebSocket.
  * 
- * @param request Request to respond to..
- * @return Size of the response.
+ * @param ws The WebSocket.
+ * @param gpio The GPIO.
  */
-static signed int create_put_response(struct http_request *request)
+static void ws_send_state(struct http_ws *ws, unsigned char gpio)
+{
+	char msg[6];
+	
+	http_ws_send(ws, msg, os_sprintf(msg, "%d=%d", gpio, GPIO_INPUT_GET(gpio)));
+}
+
+/**
+ * @brief Handle a GPIO message from a WebSocket.
+ * 
+ * Messages:
+ * 
+ * * `r<gpio>`: Read, answer `<gpio>=<state>`.
+ * * `w<gpio>=<state>`: Write, answer `<gpio>=<state>`.
+ * * `s`: Subscribe to changes, answer `<gpio>=<state>` for each
+ *   enabled GPIO. Changes are sent as `<gpio>=<state>`.
+ * * `u`: Unsubscribe, answer `u`.
+ * 
+ * Errors are answered with `!`.
+ * 
+ * @param ws The WebSocket.
+ * @param data The message.
+ * @param size Size of the message.
+ */
+static void ws_message(struct http_ws *ws, char *data, size_t size)
 {
-	signed int ret = 0;
-	//Handle trying to PUT to /rest/gpios
-	if (current_gpio < 0)
+	signed int gpio = -1;
+	unsigned char state;
+	char *pos;
+	
+	debug("GPIO WebSocket message: %s.\n", data);
+	if ((size > 1) && (isdigit((int)data[1])))
 	{
-		ret += http_send(request->connection, "<!DOCTYPE html><head><title>Method Not Allowed.</title></head><body><h1>405 Method Not Allowed.</h1><br />I won't PUT up with this.</body></html>", 145);
-		request->response.message_size = ret;
-		request->response.state = HTTP_STATE_DONE;
+		gpio = atoi(data + 1);
 	}
-	else
+	switch (data[0])
 	{
-		debug(" GPIO selected: %s.\n", request->message);
-		jsmn_parser parser;
-		jsmntok_t tokens[3];
-		int n_tokens;
-	
-		jsmn_init(&parser);
-		n_tokens  = jsmn_parse(&parser, request->message, os_strlen(request->message), tokens, 3);
-		//We expect 3 tokens in an object.
-		if ( (n_tokens < 3) || tokens[0].type != JSMN_OBJECT)
-		{
-			warn("Could not parse JSON request.\n");
-			return(RESPONSE_DONE_ERROR);				
-		}
-		for (unsigned int i = 1; i < n_tokens; i++)
-		{
-			debug(" JSON token %d.\n", i);
-			if (tokens[i].type == JSMN_STRING)
+		case 'r':
+			if (pin_enabled(gpio))
 			{
-				debug(" JSON token start with a string.\n");
-				if (strncmp(request->message + tokens[i].start, "state", 5) == 0)
+				ws_send_state(ws, gpio);
+				return;
+			}
+			break;
+		case 'w':
+			pos = os_strchr(data, '=');
+			if ((pin_enabled(gpio)) && (pos) && (isdigit((int)pos[1])))
+			{
+				state = (atoi(pos + 1) != 0);
+				if (GPIO_INPUT_GET(gpio) != state)
 				{
-					i++;
-					if (tokens[i].type == JSMN_PRIMITIVE)
+					GPIO_OUTPUT_SET(gpio, state);
+					http_rest_gpio_notify(gpio);
+					//Subscribers already know.
+					if (ws->subscribed)
 					{
-						debug(" JSON primitive comes next.\n");
-						if (isdigit((int)*(request->message + tokens[i].start)) || (*(request->message + tokens[i].start) == '-'))
-						{
-							unsigned int gpio_state;
-							
-							gpio_state = atoi(request->message + tokens[i].start);
-							debug(" State: %d.\n", gpio_state);
-							GPIO_OUTPUT_SET(current_gpio, gpio_state);
-						}
+						return;
 					}
 				}
+				ws_send_state(ws, gpio);
+				return;
 			}
-		}
+			break;
+		case 's':
+			ws->subscribed = true;
+			for (gpio = 0; gpio < REST_GPIO_PINS; gpio++)
+			{
+				if (pin_enabled(gpio))
+				{
+					ws_send_state(ws, gpio);
+				}
+			}
+			return;
+		case 'u':
+			ws->subscribed = false;
+			http_ws_send(ws, "u", 1);
+			return;
 	}
-	return(ret);
+	http_ws_send(ws, "!", 1);
 }
 
 /**
- * @brief REST handler to get/set the GPIO state and get GPIO information.
- *
- * @param request The request that we're handling.
- * @return Bytes send.
+ * @brief Upgrade to a GPIO WebSocket.
+ * 
+ * @param request The request.
+ * @return Size of the data sent, or a response done code.
  */
-signed int http_rest_gpio_handler(struct http_request *request)
+signed int http_rest_gpio_ws_handler(struct http_request *request)
 {
-	if (!request)
+	return(http_ws_upgrade(request, ws_message));
+}
+
+/**
+ * @brief Get the GPIO pin from the URI of the request.
+ * 
+ * @param request Request to get the pin from.
+ * @return True if the URI names an enabled pin.
+ */
+static bool select_pin(struct http_request *request)
+{
+	char *pin = request->uri + 12;
+
+	if (!isdigit((int)*pin))
+	{
+		debug("Rest handler GPIO will not handle request.\n");
+		return(false);
+	}
+	current_gpio = atoi(pin);
+	//Check if GPIO is enabled.
+	if (!pin_enabled(current_gpio))
+	{
+		debug("Rest handler GPIO will not handle request, pin %d not enabled.\n", current_gpio);
+		return(false);
+	}
+	debug("Rest handler GPIO%d found: %s.\n", current_gpio, request->uri);
+	return(true);
+}
+
+/**
+ * @brief Create the GET response for a pin.
+ * 
+ * @param request Request to respond to..
+ * @return Size of the response.
+ */
+static signed int create_get_response(struct http_request *request)
+{
+    debug("Creating GPIO REST GET response.\n");
+	if (!select_pin(request))
+	{
+		return(RESPONSE_DONE_CONTINUE);
+	}
+	return(create_pin_response(request));
+}
+
+/**
+ * @brief Create PUT response.
+ * 
+ * @param request Request to respond to..
+ * @return Size of the response.
+ */
+static signed int create_put_response(struct http_request *request)
+{
+	signed long gpio_state;
+	const struct json_field fields[] =
+	{
+		{ "state", JSON_FIELD_NUMBER, &gpio_state, sizeof(gpio_state) }
+	};
+	signed int found;
+
+	if (!select_pin(request))
+	{
+		return(RESPONSE_DONE_CONTINUE);
+	}
+	if (!request->message)
 	{
 		warn("Empty request.\n");
+		request->response.status_code = 400;
 		return(RESPONSE_DONE_ERROR);
 	}
-    if (os_strncmp(request->uri, "/rest/gpios", 11) == 0)
-    {
-		if (request->uri[11] == '/')
-		{
-			if (isdigit((int)request->uri[12]))
-			{
-				current_gpio = atoi(request->uri + 12);
-				//Check if GPIO is enabled.
-				if (((REST_GPIO_ENABLED >> current_gpio) & 1) == 1)
-				{
-					debug("Rest handler GPIO%d found: %s.\n", current_gpio, request->uri);				
-				}
-				else
-				{
-					debug("Rest handler GPIO will not handle request, pin %d not enabled.\n", current_gpio);
-					return(RESPONSE_DONE_CONTINUE);
-				}
-			}
-			else
-			{
-				debug("Rest handler GPIO will not handle request.\n");
-				return(RESPONSE_DONE_CONTINUE);
-			}				
-		}
-		else if (request->uri[11] == '\0')
-		{
-			debug("Rest handler GPIO (global) found: %s.\n", request->uri);
-			current_gpio = -1;
-		}
-		else
+	debug(" GPIO selected: %s.\n", request->message);
+	found = json_decode(request->message, os_strlen(request->message),
+						fields, 1);
+	if (found == JSON_DECODE_ERROR)
+	{
+		warn("Could not parse JSON request.\n");
+		request->response.status_code = 400;
+		return(RESPONSE_DONE_ERROR);
+	}
+	if (JSON_FOUND(found, 0))
+	{
+		debug(" State: %ld.\n", gpio_state);
+		gpio_state = (gpio_state != 0);
+		if (GPIO_INPUT_GET(current_gpio) != gpio_state)
 		{
-			debug("Rest handler GPIO (global) will not handle request.\n");
-			return(RESPONSE_DONE_CONTINUE);
+			GPIO_OUTPUT_SET(current_gpio, gpio_state);
+			http_rest_gpio_notify(current_gpio);
 		}
-    }
-    
-    return(http_simple_GET_PUT_handler(request, create_get_response, create_put_response, NULL));
+	}
+	return(0);
 }
+
+/**
+ * @brief REST callbacks for the list of enabled GPIO's.
+ */
+const struct http_method_handlers http_rest_gpios_methods =
+{
+	.get = create_enabled_response,
+	.put = NULL,
+	.free = NULL
+};
+
+/**
+ * @brief REST callbacks to get/set the state of a GPIO.
+ */
+const struct http_method_handlers http_rest_gpio_methods =
+{
+	.get = create_get_response,
+	.put = create_put_response,
+	.free = NULL
+};
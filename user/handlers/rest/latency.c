@@ -0,0 +1,126 @@
+/**
+ * @file latency.c
+ *
+ * @brief REST interface for request latency histograms.
+ * 
+ * Maps `/rest/fw/latency` to a JSON object with the upper bound of each
+ * histogram bucket in µs, and an array with an object per route. The
+ * object has the URI and the order of the route, as several routes can
+ * share an URI, the number of responses, and a histogram per interval.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "osapi.h"
+#include "c_types.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "tools/json-writer.h"
+#include "slighttp/http.h"
+#include "slighttp/http-handler.h"
+#include "slighttp/http-latency.h"
+
+/**
+ * @brief Write the latency statistics.
+ * 
+ * @param writer The JSON writer.
+ * @return Size of the JSON.
+ */
+static size_t write_latency(struct json_writer *writer)
+{
+	struct http_latency *latency;
+	unsigned char interval;
+	unsigned char bucket;
+	
+	json_begin_object(writer);
+	json_key(writer, "bounds");
+	json_begin_array(writer);
+	for (bucket = 0; bucket < HTTP_LATENCY_BUCKETS - 1; bucket++)
+	{
+		json_number(writer, http_latency_bounds[bucket]);
+	}
+	json_end_array(writer);
+	json_key(writer, "routes");
+	json_begin_array(writer);
+	for (latency = http_latency_routes; latency; latency = latency->next)
+	{
+		json_begin_object(writer);
+		json_key(writer, "uri");
+		json_string(writer, latency->uri, os_strlen(latency->uri));
+		json_key(writer, "order");
+		json_number(writer, latency->order);
+		json_key(writer, "count");
+		json_number(writer, latency->count);
+		for (interval = 0; interval < HTTP_LATENCY_INTERVALS; interval++)
+		{
+			json_key(writer, http_latency_interval_names[interval]);
+			json_begin_array(writer);
+			for (bucket = 0; bucket < HTTP_LATENCY_BUCKETS; bucket++)
+			{
+				json_number(writer, latency->histogram[interval][bucket]);
+			}
+			json_end_array(writer);
+		}
+		json_end_object(writer);
+	}
+	json_end_array(writer);
+	json_end_object(writer);
+	return(json_writer_size(writer));
+}
+
+/**
+ * @brief Create the response.
+ * 
+ * @param request Request to respond to..
+ * @return Size of the response.
+ */
+static signed int create_get_response(struct http_request *request)
+{
+	struct json_writer writer;
+	size_t size;
+	
+    debug("Creating latency REST response.\n");
+
+	if (request->response.message)
+	{
+		warn("Message is already set.\n");
+		return(os_strlen(request->response.message));
+	}
+	json_writer_init(&writer, NULL, 0);
+	size = write_latency(&writer);
+	request->response.message = db_malloc(size + 1, "request->response.message create_get_response");
+	if (!request->response.message)
+	{
+		error("Could not allocate memory for latency statistics.\n");
+		request->response.status_code = 500;
+		return(RESPONSE_DONE_CONTINUE);
+	}
+	json_writer_init(&writer, request->response.message, size + 1);
+	return(write_latency(&writer));
+}
+
+/**
+ * @brief REST callbacks for request latency statistics.
+ */
+const struct http_method_handlers http_rest_latency_methods =
+{
+	.get = create_get_response,
+	.put = NULL,
+	.free = NULL
+};
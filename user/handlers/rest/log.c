@@ -0,0 +1,112 @@
+/**
+ * @file log.c
+ *
+ * @brief REST interface for the access log.
+ * 
+ * Maps `/rest/fw/log` to a JSON object with the number of dropped
+ * records, and an array of the most recent access log lines, oldest
+ * first.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "osapi.h"
+#include "c_types.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "tools/json-gen.h"
+#include "slighttp/http.h"
+#include "slighttp/http-handler.h"
+#include "slighttp/http-log.h"
+
+/**
+ * @brief Create a JSON string from a log line.
+ * 
+ * @param line The log line.
+ * @param string Where to put the string, at least twice the line
+ *               length plus three bytes.
+ */
+static void create_string(const char *line, char *string)
+{
+	*string++ = '\"';
+	while (*line)
+	{
+		if ((*line == '\"') || (*line == '\\'))
+		{
+			*string++ = '\\';
+		}
+		*string++ = *line++;
+	}
+	*string++ = '\"';
+	*string = '\0';
+}
+
+/**
+ * @brief Create the response.
+ * 
+ * @param request Request to respond to..
+ * @return Size of the response.
+ */
+static signed int create_get_response(struct http_request *request)
+{
+	char line[HTTP_LOG_LINE_SIZE];
+	char string[HTTP_LOG_LINE_SIZE * 2 + 3];
+	char *response;
+	char *lines = NULL;
+	char *pair;
+	unsigned short i, n;
+	
+    debug("Creating access log REST response.\n");
+
+	if (request->response.message)
+	{
+		warn("Message is already set.\n");
+		return(os_strlen(request->response.message));
+	}
+	response = json_add_number(NULL, "dropped", http_log_dropped);
+	n = http_log_count();
+	for (i = 0; i < n; i++)
+	{
+		http_log_format(i, line);
+		create_string(line, string);
+		lines = json_add_to_array(lines, string);
+	}
+	if (!lines)
+	{
+		lines = db_malloc(3, "lines create_get_response");
+		os_memcpy(lines, JSON_TYPE_ARRAY, 3);
+	}
+	pair = json_create_pair("lines", lines, false);
+	db_free(lines);
+	response = json_add_to_object(response, pair);
+	db_free(pair);
+	
+	request->response.message = response;
+	return(os_strlen(request->response.message));
+}
+
+/**
+ * @brief REST callbacks for the access log.
+ */
+const struct http_method_handlers http_rest_log_methods =
+{
+	.get = create_get_response,
+	.put = NULL,
+	.free = NULL
+};
@@ -29,12 +29,12 @@
 #include "c_types.h"
 #include "user_interface.h"
 #include "user_config.h"
-#include "tools/strxtra.h"
 #include "tools/json-gen.h"
 #include "slighttp/http.h"
 #include "slighttp/http-mime.h"
 #include "slighttp/http-handler.h"
 #include "slighttp/http-response.h"
+#include "handlers/fs/http-fs-cache.h"
 
 /**
  * @brief Create the response.
@@ -47,19 +47,20 @@ static signed int create_get_response(struct http_request *request)
     debug("Creating memory REST response.\n");
 
 	if (!request->response.message)
-	{	
-		char *pair;
+	{
+		struct http_fs_cache_stats *cache = &http_fs_cache_counters;
+		unsigned long lookups = cache->hits + cache->misses;
 		char *response;
-		char free_mem[10];
 
-		if(!itoa(system_get_free_heap_size(), free_mem, 10))
-		{
-			error("Could not get free memory size.\n");
-			return(0);
-		}
-		pair = json_create_pair("free", free_mem, true);
-		response = json_add_to_object(NULL, pair);
-		db_free(pair);
+		response = json_add_number(NULL, "free", system_get_free_heap_size());
+		response = json_add_number(response, "cache_used", cache->used);
+		response = json_add_number(response, "cache_size", HTTP_FS_CACHE_SIZE);
+		response = json_add_number(response, "cache_entries", cache->entries);
+		response = json_add_number(response, "cache_hits", cache->hits);
+		response = json_add_number(response, "cache_misses", cache->misses);
+		//Hit rate in percent.
+		response = json_add_number(response, "cache_hit_rate",
+								   lookups ? (cache->hits * 100) / lookups : 0);
 	
 		request->response.message = response;
 	}
@@ -71,23 +72,11 @@ static signed int create_get_response(struct http_request *request)
 }
 
 /**
- * @brief REST handler to get free mem.
- *
- * @param request The request that we're handling.
- * @return Bytes send.
+ * @brief REST callbacks for memory info.
  */
-signed int http_rest_mem_handler(struct http_request *request)
+const struct http_method_handlers http_rest_mem_methods =
 {
-	if (!request)
-	{
-		warn("Empty request.\n");
-		return(RESPONSE_DONE_ERROR);
-	}
-	if (os_strncmp(request->uri, "/rest/fw/mem\0", 13) != 0)
-    {
-		debug("REST memory handler will not handle request.\n"); 
-		return(RESPONSE_DONE_CONTINUE);
-    }
-	
-	return(http_simple_GET_PUT_handler(request, create_get_response, NULL, NULL));
-}
+	.get = create_get_response,
+	.put = NULL,
+	.free = NULL
+};
@@ -6,6 +6,14 @@
  * 
  * Maps `/rest/net/networks/` to a list of all access points.
  * 
+ * Scanning takes seconds, and takes the radio off the channel, so the
+ * result is kept for #REST_NET_NAMES_TTL ms, and answers all requests
+ * in that time. Requests arriving while a scan is running wait for it,
+ * and are all answered when it is done. The response is an array of
+ * objects, strongest first, one for each network name:
+ * 
+ *     [{"ssid":"name","rssi":-60,"channel":6,"auth":"wpa2"}]
+ * 
  * @copyright
  * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
  * 
@@ -30,20 +38,66 @@
 #include "osapi.h"
 #include "user_interface.h"
 #include "user_config.h"
-#include "tools/json-gen.h"
+#include "tools/json-writer.h"
 #include "slighttp/http.h"
 #include "slighttp/http-mime.h"
 #include "slighttp/http-response.h"
 #include "slighttp/http-handler.h"
+#include "slighttp/http-sched.h"
+
+#ifndef REST_NET_NAMES_TTL
+/**
+ * @brief Time in ms a scan result is used, before scanning again.
+ */
+#define REST_NET_NAMES_TTL 30000
+#endif
 
+#ifndef REST_NET_NAMES_MAX
 /**
- * @brief Stores the request while waiting for the callback.
+ * @brief Maximum number of networks kept, the weakest are left out.
  */
-static struct http_request *waiting_request = NULL;
+#define REST_NET_NAMES_MAX 16
+#endif
+
+#ifndef REST_NET_NAMES_WAITING
 /**
- * @brief Status of SDK call.
+ * @brief Maximum number of requests waiting for a scan.
  */
-static bool error = false;
+#define REST_NET_NAMES_WAITING 4
+#endif
+
+#ifndef REST_NET_NAMES_REFRESH
+/**
+ * @brief Time in ms between background scans, 0 to disable them.
+ * 
+ * Only used when enabled with #http_rest_net_names_refresh. Should be
+ * less than #REST_NET_NAMES_TTL, to always have a fresh result.
+ */
+#define REST_NET_NAMES_REFRESH 0
+#endif
+
+/**
+ * @brief A network found by a scan.
+ */
+struct rest_net_names_ap
+{
+	/**
+	 * @brief The network name, zero terminated.
+	 */
+	char ssid[33];
+	/**
+	 * @brief Signal strength in dBm.
+	 */
+	sint8 rssi;
+	/**
+	 * @brief WIFI channel.
+	 */
+	uint8 channel;
+	/**
+	 * @brief Authentication mode, an AUTH_MODE value.
+	 */
+	uint8 authmode;
+};
 
 /**
  * @brief Context for the network name handler.
@@ -58,12 +112,158 @@ struct rest_net_names_context
 	 * @brief The number of bytes to send.
 	 */
 	size_t size;
+	/**
+	 * @brief True if the scan, the request waited for, failed.
+	 */
+	bool failed;
 };
 
+/**
+ * @brief Names of the authentication modes, by AUTH_MODE value.
+ */
+static const char *auth_names[] =
+{
+	"open", "wep", "wpa", "wpa2", "wpa/wpa2"
+};
+
+/**
+ * @brief Networks found by the last scan, strongest first.
+ */
+static struct rest_net_names_ap aps[REST_NET_NAMES_MAX];
+/**
+ * @brief Number of networks in #aps.
+ */
+static unsigned char n_aps = 0;
+/**
+ * @brief System time in µs of the last successful scan.
+ */
+static uint32 scan_time;
+/**
+ * @brief True if #aps holds a scan result.
+ */
+static bool scanned = false;
+/**
+ * @brief True while a scan is running.
+ */
+static bool scanning = false;
+/**
+ * @brief Requests waiting for the scan.
+ */
+static struct http_request *waiting[REST_NET_NAMES_WAITING];
+/**
+ * @brief Timer for background scans.
+ */
+static os_timer_t refresh_timer;
+
+/**
+ * @brief Check if the last scan result can be used.
+ * 
+ * @return True if it can.
+ */
+static bool fresh(void)
+{
+	return((scanned) &&
+		   ((system_get_time() - scan_time) < (REST_NET_NAMES_TTL * 1000UL)));
+}
+
+/**
+ * @brief Add a network to the list, keeping it sorted by signal strength.
+ * 
+ * Networks with the same name are listed once, with the values of the
+ * strongest.
+ * 
+ * @param info The network from the scan.
+ */
+static void add_ap(struct bss_info *info)
+{
+	size_t ssid_size;
+	unsigned char i;
+	
+	//SSID cannot be longer than 32 char, and need not be zero terminated.
+	for (ssid_size = 0; (ssid_size < 32) && (info->ssid[ssid_size]);
+		 ssid_size++);
+	if (!ssid_size)
+	{
+		//Hidden network.
+		return;
+	}
+	for (i = 0; i < n_aps; i++)
+	{
+		if ((os_strncmp(aps[i].ssid, (char *)info->ssid, ssid_size) == 0) &&
+			(aps[i].ssid[ssid_size] == '\0'))
+		{
+			if (aps[i].rssi >= info->rssi)
+			{
+				return;
+			}
+			//Remove the weaker one.
+			os_memmove(&aps[i], &aps[i + 1],
+					   sizeof(struct rest_net_names_ap) * (n_aps - i - 1));
+			n_aps--;
+			break;
+		}
+	}
+	for (i = 0; (i < n_aps) && (aps[i].rssi >= info->rssi); i++);
+	if (i >= REST_NET_NAMES_MAX)
+	{
+		return;
+	}
+	if (n_aps == REST_NET_NAMES_MAX)
+	{
+		//Drop the weakest.
+		n_aps--;
+	}
+	os_memmove(&aps[i + 1], &aps[i],
+			   sizeof(struct rest_net_names_ap) * (n_aps - i));
+	os_memcpy(aps[i].ssid, info->ssid, ssid_size);
+	aps[i].ssid[ssid_size] = '\0';
+	aps[i].rssi = info->rssi;
+	aps[i].channel = info->channel;
+	aps[i].authmode = info->authmode;
+	n_aps++;
+}
+
+/**
+ * @brief Write the networks as a JSON array.
+ * 
+ * @param writer The JSON writer.
+ * @return Size of the JSON.
+ */
+static size_t write_names(struct json_writer *writer)
+{
+	unsigned char i;
+	
+	json_begin_array(writer);
+	for (i = 0; i < n_aps; i++)
+	{
+		json_begin_object(writer);
+		json_key(writer, "ssid");
+		json_string(writer, aps[i].ssid, os_strlen(aps[i].ssid));
+		json_key(writer, "rssi");
+		json_signed(writer, aps[i].rssi);
+		json_key(writer, "channel");
+		json_number(writer, aps[i].channel);
+		json_key(writer, "auth");
+		if (aps[i].authmode < (sizeof(auth_names) / sizeof(auth_names[0])))
+		{
+			json_string(writer, auth_names[aps[i].authmode],
+						os_strlen(auth_names[aps[i].authmode]));
+		}
+		else
+		{
+			json_number(writer, aps[i].authmode);
+		}
+		json_end_object(writer);
+	}
+	json_end_array(writer);
+	return(json_writer_size(writer));
+}
+
 /**
  * @brief Callback for when the ESP8266 is done finding access points.
  * 
- * This sends off the headers, restarting the send cycle.
+ * Stores the result, and queues the waiting requests, which will find
+ * a fresh result, or that the scan failed.
  * 
  * @param arg Pointer to a ESP8266 scaninfo struct, with an AP list.
  * @param status ESP8266 enum STATUS, telling how the scan went.
@@ -71,210 +271,259 @@ struct rest_net_names_context
 static void scan_done_cb(void *arg, STATUS status)
 {
 	struct bss_info *current_ap_info;
-	struct bss_info *scn_info;
-	size_t ssid_size;
-	size_t size;
-	char *json_ssid;
-	char *json_ssid_pos = NULL;
-	char *json_response = NULL;
-	struct http_request *request;
+	struct rest_net_names_context *context;
+	unsigned char i;
+	bool queued = false;
 	
 	debug("AP scan callback for REST.\n");
+	scanning = false;
 	if (status == OK)
 	{
 		debug(" Scanning went OK (%p).\n", arg);
-		scn_info = (struct bss_info *)arg;
-		debug(" Processing AP list (%p, %p).\n", scn_info, scn_info->next.stqe_next);
-		debug(" AP names:\n");
+		n_aps = 0;
 		//Skip first according to docs.
-		for (current_ap_info = scn_info->next.stqe_next;
+		for (current_ap_info = ((struct bss_info *)arg)->next.stqe_next;
 			 current_ap_info != NULL;
 			 current_ap_info = current_ap_info->next.stqe_next)
 		{
-			debug("  %s.\n", current_ap_info->ssid);
-			//SSID cannot be longer than 32 char.
-			ssid_size = strlen((char *)(current_ap_info->ssid));
-			if (ssid_size > 32)
-			{
-				//" + SSID + " + \0
-				size = 35;
-			}
-			else
-			{
-				//" + " + \0
-				size = ssid_size + 3;
-			}
-			json_ssid = db_malloc(size, "scan_done_sb json_ssid");
-			json_ssid_pos = json_ssid;
-			*json_ssid_pos++ = '\"';
-			if (ssid_size > 32)
-			{
-				os_memcpy(json_ssid_pos, current_ap_info->ssid, 32);
-				json_ssid_pos += 32;
-			}
-			else
-			{
-				os_memcpy(json_ssid_pos, current_ap_info->ssid, ssid_size);
-				json_ssid_pos += ssid_size;
-			}
-			os_memcpy(json_ssid_pos, "\"\0", 2);
-			json_response = json_add_to_array(json_response, json_ssid);
-			db_free(json_ssid);
-		}	
+			add_ap(current_ap_info);
+		}
+		debug(" %d networks.\n", n_aps);
+		scan_time = system_get_time();
+		scanned = true;
 	}
 	else
 	{
 		error(" Scanning AP's.\n");
-		error = true;
 	}
-	request = waiting_request;
-	if (request->connection)
+	for (i = 0; i < REST_NET_NAMES_WAITING; i++)
 	{
-		if (!error)
+		if (waiting[i])
 		{
-			((struct rest_net_names_context *)request->response.context)->response = json_response;
-			((struct rest_net_names_context *)request->response.context)->size = os_strlen(json_response);
+			context = waiting[i]->response.context;
+			context->failed = (status != OK);
+			//Start over, now that there is something to answer.
+			waiting[i]->response.state = HTTP_STATE_NONE;
+			http_sched_add(waiting[i]);
+			waiting[i] = NULL;
+			queued = true;
 		}
-		else
-		{
-			((struct rest_net_names_context *)request->response.context)->response = "[\"error\"]";
-			((struct rest_net_names_context *)request->response.context)->size = os_strlen(((struct rest_net_names_context *)request->response.context)->response);
-		}
-
-		//We'll be sending headers next.
-		request->response.state = HTTP_STATE_HEADERS;
-		http_handle_response(request);
 	}
-	else
+	if (queued)
 	{
-		error(" No connection for sending network names.\n");
+		http_sched_run();
 	}
 }
 
 /**
- * @brief Start scanning for WIFI network names.
+ * @brief Start scanning for WIFI network names, if not already scanning.
  * 
- * @param request The request that brought us here.
+ * @return True if a scan is running.
  */
-static void scan_net_names(struct http_request *request)
+static bool scan_net_names(void)
 {
+	if (scanning)
+	{
+		return(true);
+	}
 	debug("Start network names scan.\n");
-
-	//Get set if there is an error in the callback.
-	error = false;
-	//Prevent more scans until the call back has done it job.
-	waiting_request = request;
-	debug(" Starting scan.\n");
 	if (wifi_station_scan(NULL, &scan_done_cb))
 	{
 		debug(" Scanning for AP's.\n");
+		scanning = true;
 	}
 	else
 	{
 		error(" Could not scan AP's.\n");
 	}
+	return(scanning);
+}
+
+/**
+ * @brief Have a request wait for the scan, starting it if needed.
+ * 
+ * @param request The request.
+ * @return True if the request is waiting.
+ */
+static bool wait_for_scan(struct http_request *request)
+{
+	unsigned char i;
+	
+	for (i = 0; i < REST_NET_NAMES_WAITING; i++)
+	{
+		if (!waiting[i])
+		{
+			break;
+		}
+	}
+	if (i == REST_NET_NAMES_WAITING)
+	{
+		warn("Too many requests waiting for the network scan.\n");
+		return(false);
+	}
+	if (!scan_net_names())
+	{
+		return(false);
+	}
+	debug(" Request %p waits for the scan.\n", request);
+	waiting[i] = request;
+	return(true);
+}
+
+/**
+ * @brief Scan in the background, so that requests find a fresh result.
+ * 
+ * @param arg Not used.
+ */
+static void refresh(void *arg)
+{
+	scan_net_names();
+}
+
+/**
+ * @brief Start or stop scanning in the background.
+ * 
+ * Scans every #REST_NET_NAMES_REFRESH ms, if it is not 0.
+ * 
+ * @param enable True to start, false to stop.
+ */
+void http_rest_net_names_refresh(bool enable)
+{
+	os_timer_disarm(&refresh_timer);
+	if ((enable) && (REST_NET_NAMES_REFRESH))
+	{
+		debug("Scanning for networks every %d ms.\n", REST_NET_NAMES_REFRESH);
+		os_timer_setfn(&refresh_timer, (os_timer_func_t *)refresh, NULL);
+		os_timer_arm(&refresh_timer, REST_NET_NAMES_REFRESH, 1);
+		scan_net_names();
+	}
 }
 
 /**
- * @brief REST handler to get/set the GPIO state and get GPIO information.
+ * @brief REST handler to scan for network names.
  *
+ * Only registered for HEAD and GET. While waiting for a scan, the
+ * request is kept in HTTP_STATE_STATUS, so that the handler gets to
+ * clean up, if the connection is closed.
+ * 
  * @param request The request that we're handling.
  * @return Bytes send.
  */
 signed int http_rest_net_names_handler(struct http_request *request)
 {
+	struct rest_net_names_context *context;
+	struct json_writer writer;
 	signed int ret = 0;
+	size_t size;
+	unsigned char i;
+	bool use_cache;
 		
 	if (!request)
 	{
 		warn("Empty request.\n");
 		return(RESPONSE_DONE_ERROR);
 	}
-	if ((request->type != HTTP_GET) &&
-		(request->type != HTTP_HEAD))
-	{
-		debug(" Rest handler net-names only supports HEAD, GET.\n");
-		return(RESPONSE_DONE_CONTINUE);
-	}
-	if (os_strncmp(request->uri, "/rest/net/networks\0", 19) != 0)
-    {
-		debug("Rest handler net-names will not handle request,\n");
-        return(RESPONSE_DONE_CONTINUE);
-    }
-     
+	context = request->response.context;
+
 	if (request->response.state == HTTP_STATE_NONE)
 	{
-		if ((request->type == HTTP_HEAD) ||
-		    (request->type == HTTP_GET))
+		if ((request->type != HTTP_HEAD) &&
+		    (request->type != HTTP_GET))
+		{
+			return(RESPONSE_DONE_CONTINUE);
+		}
+		if (!context)
 		{
-			if (!waiting_request)
+			context = db_zalloc(sizeof(struct rest_net_names_context),
+								"request->response.context http_rest_net_names_handler");
+			if (!context)
 			{
-				//Only do stuff if we're not already waiting. 
-				//Get some mem if we need it.
-				if (!request->response.context)
-				{
-					request->response.context = db_zalloc(sizeof(struct rest_net_names_context), "request->response.context scan_done_cb");
-				}
-				//Start scanning.
-				if (!((struct rest_net_names_context *)request->response.context)->response)
-				{
-					scan_net_names(request);
-				}
+				error("Could not allocate memory for network names.\n");
+				request->response.status_code = 500;
+				return(RESPONSE_DONE_CONTINUE);
 			}
-			//Done, scan callback will take over and clean up afterwards.
+			request->response.context = context;
+		}
+		use_cache = fresh();
+		if ((context->failed) || ((!use_cache) && (!wait_for_scan(request))))
+		{
+			//Let the error handlers have the request.
+			db_free(context);
+			request->response.context = NULL;
+			request->response.status_code = 503;
+			return(RESPONSE_DONE_CONTINUE);
+		}
+		if (!use_cache)
+		{
+			//The scan callback will queue the request again.
+			request->response.state = HTTP_STATE_STATUS;
 			return(RESPONSE_DONE_NO_DEALLOC);
 		}
+		json_writer_init(&writer, NULL, 0);
+		size = write_names(&writer);
+		context->response = db_malloc(size + 1, "context->response http_rest_net_names_handler");
+		if (!context->response)
+		{
+			error("Could not allocate memory for network names.\n");
+			db_free(context);
+			request->response.context = NULL;
+			request->response.status_code = 500;
+			return(RESPONSE_DONE_CONTINUE);
+		}
+		json_writer_init(&writer, context->response, size + 1);
+		context->size = write_names(&writer);
+		debug(" Networks: %s.\n", context->response);
+		request->response.state = HTTP_STATE_HEADERS;
 	}
 	
-	if (request->response.state == HTTP_STATE_HEADERS)
+	if (request->response.state == HTTP_STATE_STATUS)
 	{
-		if ((request->type == HTTP_HEAD) ||
-		    (request->type == HTTP_GET))
-		{
-			//This is the answer, we're called from the scan callback.
-			request->response.status_code = 200;
-			//Send status and headers.
-			ret += http_send_status_line(request->connection, request->response.status_code);
-			ret += http_send_default_headers(request, ((struct rest_net_names_context *)request->response.context)->size, "json");
-			if (request->type == HTTP_HEAD)
-			{
-				request->response.state = HTTP_STATE_DONE;
-				return(ret);
-			}
-			else
-			{
-				//Go on to sending the file.
-				request->response.state = HTTP_STATE_MESSAGE;
-			}
-		}
+		//Still waiting for the scan.
+		return(RESPONSE_DONE_NO_DEALLOC);
 	}
 	
-	if (request->response.state == HTTP_STATE_MESSAGE)
+	if (request->response.state == HTTP_STATE_HEADERS)
 	{
-		if (request->type == HTTP_GET)
+		request->response.status_code = 200;
+		//Send status and headers.
+		ret += http_send_status_line(request->connection, request->response.status_code);
+		ret += http_send_default_headers(request, context->size, MIME_JSON);
+		if (request->type == HTTP_HEAD)
 		{
-			debug(" Response: %s.\n", ((struct rest_net_names_context *)request->response.context)->response);
-			ret += http_send(request->connection, 
-					 ((struct rest_net_names_context *)request->response.context)->response,
-					 ((struct rest_net_names_context *)request->response.context)->size);
 			request->response.state = HTTP_STATE_DONE;
-			request->response.message_size = ((struct rest_net_names_context *)request->response.context)->size;
 			return(ret);
 		}
+		//Go on to sending the list.
+		request->response.state = HTTP_STATE_MESSAGE;
+	}
+	
+	if (request->response.state == HTTP_STATE_MESSAGE)
+	{
+		ret += http_send_ref(request->connection, context->response,
+							 context->size);
+		request->response.state = HTTP_STATE_DONE;
+		request->response.message_size = context->size;
+		return(ret);
 	}
 	    
 	if (request->response.state == HTTP_STATE_DONE)
 	{
-		debug("Freeing network names REST handler data (%p).\n", request->response.context);	
-		if (request->response.context)
+		debug("Freeing network names REST handler data (%p).\n", context);
+		for (i = 0; i < REST_NET_NAMES_WAITING; i++)
+		{
+			if (waiting[i] == request)
+			{
+				waiting[i] = NULL;
+			}
+		}
+		if (context)
 		{	
-			if (((struct rest_net_names_context *)request->response.context)->response)
+			if (context->response)
 			{
-				db_free(((struct rest_net_names_context *)request->response.context)->response);
+				db_free(context->response);
 			}
-			db_free(request->response.context);
+			db_free(context);
 			request->response.context = NULL;
-			waiting_request = NULL;
 		}
 	}
 	return(RESPONSE_DONE_FINAL);
@@ -30,7 +30,7 @@
 #include "eagle_soc.h"
 #include "osapi.h"
 #include "user_interface.h"
-#include "tools/jsmn.h"
+#include "tools/json-decode.h"
 #include "user_config.h"
 #include "slighttp/http.h"
 #include "slighttp/http-mime.h"
@@ -47,51 +47,45 @@
  */
 static signed int create_put_response(struct http_request *request)
 {
-	unsigned int i;
-	jsmn_parser parser;
-	jsmntok_t tokens[3];
-	int n_tokens;
+	struct station_config sc;
+	//A 64 digit PSK has no zero byte in sc.password.
+	char password[sizeof(sc.password) + 1];
+	const struct json_field fields[] =
+	{
+		{ "password", JSON_FIELD_STRING, password, sizeof(password) }
+	};
+	signed int found;
 
-	jsmn_init(&parser);
-	n_tokens  = jsmn_parse(&parser, request->message, os_strlen(request->message), tokens, 3);
-	//We expect 3 tokens in an object.
-	if ( (n_tokens < 3) || tokens[0].type != JSMN_OBJECT)
+	if (!request->message)
+	{
+		warn("Empty request.\n");
+		request->response.status_code = 400;
+		return(RESPONSE_DONE_ERROR);
+	}
+	wifi_station_get_config(&sc);
+	found = json_decode(request->message, os_strlen(request->message),
+						fields, 1);
+	if (found == JSON_DECODE_ERROR)
 	{
 		warn("Could not parse JSON request.\n");
-		return(RESPONSE_DONE_ERROR);				
+		request->response.status_code = 400;
+		return(RESPONSE_DONE_ERROR);
 	}
-	for (i = 1; i < n_tokens; i++)
+	if (JSON_FOUND(found, 0))
 	{
-		debug(" JSON token %d.\n", i);
-		if (tokens[i].type == JSMN_STRING)
+		if (!password[0])
+		{
+			debug(" Empty password received. Password unchanged.\n");
+		}
+		else
 		{
-			debug(" JSON token start with a string.\n");
-			if (strncmp(request->message + tokens[i].start, "password", 5) == 0)
+			os_memset(sc.password, 0, sizeof(sc.password));
+			os_memcpy(sc.password, password, os_strlen(password));
+			sc.bssid_set = 0;
+			debug(" Network password %s.\n", password);
+			if (!wifi_station_set_config(&sc))
 			{
-				debug(" JSON password.\n");
-				i++;
-				if (tokens[i].type == JSMN_STRING)
-				{
-					debug(" JSON string comes next.\n");
-					if (tokens[i].start == tokens[i].end)
-					{
-						debug(" Empty password received. Password unchanged.\n");
-					}
-					else
-					{
-						struct station_config sc;
-						
-						wifi_station_get_config(&sc);
-						sc.bssid_set = 0;
-						os_memcpy(&sc.password, request->message + tokens[i].start, tokens[i].end - tokens[i].start);
-						sc.password[tokens[i].end - tokens[i].start] = '\0';
-						debug(" Network password %s.\n", sc.password);
-						if (!wifi_station_set_config(&sc))
-						{
-							error("Could set network configuration.\n");
-						}
-					}
-				}
+				error("Could set network configuration.\n");
 			}
 		}
 	}
@@ -100,29 +94,11 @@ static signed int create_put_response(struct http_request *request)
 }
 
 /**
- * @brief REST handler for setting the password for the default network.
- *
- * @param request The request that we're handling.
- * @return Bytes send.
+ * @brief REST callbacks for setting the password for the default network.
  */
-signed int http_rest_net_passwd_handler(struct http_request *request)
+const struct http_method_handlers http_rest_net_passwd_methods =
 {
-	if (!request)
-	{
-		warn("Empty request.\n");
-		return(RESPONSE_DONE_ERROR);
-	}
-	if (request->type != HTTP_PUT)
-	{
-		debug("REST handler network password only supports PUT.\n");
-		return(RESPONSE_DONE_CONTINUE);
-	}
-
-    if (os_strncmp(request->uri, "/rest/net/password\0", 19) != 0)
-    {
-		debug("REST handler network password will not handle request,\n"); 
-        return(RESPONSE_DONE_CONTINUE);
-    }
-	
-	return(http_simple_GET_PUT_handler(request, NULL, create_put_response, NULL));
-}
+	.get = NULL,
+	.put = create_put_response,
+	.free = NULL
+};
@@ -30,7 +30,7 @@
 #include "c_types.h"
 #include "ip_addr.h"
 #include "user_interface.h"
-#include "tools/jsmn.h"
+#include "tools/json-decode.h"
 #include "tools/json-gen.h"
 #include "user_config.h"
 #include "slighttp/http.h"
@@ -108,66 +108,53 @@ static signed int create_get_response(struct http_request *request)
  */
 static signed int create_put_response(struct http_request *request)
 {
-	unsigned int i;
+	struct station_config sc;
+	//A 32 byte SSID has no zero byte in sc.ssid.
+	char ssid[sizeof(sc.ssid) + 1];
+	char name[32];
+	const struct json_field fields[] =
+	{
+		{ "network", JSON_FIELD_STRING, ssid, sizeof(ssid) },
+		{ "hostname", JSON_FIELD_STRING, name, sizeof(name) }
+	};
+	signed int found;
 	
 	debug("Creating network REST PUT response.\n");
+	if (!request->message)
+	{
+		warn("Empty request.\n");
+		request->response.status_code = 400;
+		return(RESPONSE_DONE_ERROR);
+	}
 	debug(" Request message: %s.\n", request->message);
-	
-	jsmn_parser parser;
-	jsmntok_t tokens[3];
-	int n_tokens;
 
-	jsmn_init(&parser);
-	n_tokens  = jsmn_parse(&parser, request->message, os_strlen(request->message), tokens, 5);
-	//We expect at least 2 tokens in an object.
-	if ( (n_tokens < 3) || tokens[0].type != JSMN_OBJECT)
+	//Keep the password, if only the name changes.
+	wifi_station_get_config(&sc);
+	found = json_decode(request->message, os_strlen(request->message),
+						fields, 2);
+	if (found == JSON_DECODE_ERROR)
 	{
 		warn("Could not parse JSON request.\n");
-		return(RESPONSE_DONE_ERROR);				
+		request->response.status_code = 400;
+		return(RESPONSE_DONE_ERROR);
 	}
-	for (i = 1; i < n_tokens; i++)
+	if (JSON_FOUND(found, 0))
 	{
-		debug(" JSON token %d.\n", i);
-		if (tokens[i].type == JSMN_STRING)
+		os_memset(sc.ssid, 0, sizeof(sc.ssid));
+		os_memcpy(sc.ssid, ssid, os_strlen(ssid));
+		sc.bssid_set = 0;
+		debug(" Network name %s.\n", ssid);
+		if (!wifi_station_set_config(&sc))
 		{
-			debug(" JSON token start with a string.\n");
-			if (strncmp(request->message + tokens[i].start, "network", 5) == 0)
-			{
-				debug(" JSON network name.\n");
-				i++;
-				if (tokens[i].type == JSMN_STRING)
-				{
-					debug(" JSON string comes next.\n");
-					struct station_config sc;
-					
-					sc.bssid_set = 0;
-					os_memcpy(&sc.ssid, request->message + tokens[i].start, tokens[i].end - tokens[i].start);
-					sc.ssid[tokens[i].end - tokens[i].start] = '\0';
-					debug(" Network name %s.\n", sc.ssid);
-					if (!wifi_station_set_config(&sc))
-					{
-						error("Could set not network name.\n");
-					}
-				}
-			}
-			if (strncmp(request->message + tokens[i].start, "hostname", 5) == 0)
-			{
-				debug(" JSON host name.\n");
-				i++;
-				if (tokens[i].type == JSMN_STRING)
-				{
-					debug(" JSON string comes next.\n");
-					char name[32];
-					
-					os_memcpy(name, request->message + tokens[i].start, tokens[i].end - tokens[i].start);
-					name[tokens[i].end - tokens[i].start] = '\0';
-					debug(" Hostname %s.\n", name);
-					if (!wifi_station_set_hostname(name))
-					{
-						error("Could not set hostname.\n");
-					}
-				}
-			}
+			error("Could set not network name.\n");
+		}
+	}
+	if (JSON_FOUND(found, 1))
+	{
+		debug(" Hostname %s.\n", name);
+		if (!wifi_station_set_hostname(name))
+		{
+			error("Could not set hostname.\n");
 		}
 	}
 
@@ -175,23 +162,11 @@ static signed int create_put_response(struct http_request *request)
 }
 
 /**
- * @brief REST handler to get/set the default network.
- *
- * @param request The request that we're handling.
- * @return Bytes send.
+ * @brief REST callbacks to get/set the default network.
  */
-signed int http_rest_network_handler(struct http_request *request)
+const struct http_method_handlers http_rest_network_methods =
 {
-	if (!request)
-	{
-		warn("Empty request.\n");
-		return(RESPONSE_DONE_ERROR);
-	}
-	if (os_strncmp(request->uri, "/rest/net/network\0", 18) != 0)
-    {
-		debug("Rest handler network will not handle request.\n"); 
-		return(RESPONSE_DONE_CONTINUE);
-    }
-	
-	return(http_simple_GET_PUT_handler(request, create_get_response, create_put_response, NULL));
-}
+	.get = create_get_response,
+	.put = create_put_response,
+	.free = NULL
+};
@@ -27,9 +27,9 @@
 #include "slighttp/http-handler.h"
 
 /**
- * @brief REST handler for the default network name.
+ * @brief REST callbacks for the default network name.
  */
-extern signed int http_rest_network_handler(struct http_request *request);
+extern const struct http_method_handlers http_rest_network_methods;
 
 /**
  * @brief REST handler for the scanning for available networks.
@@ -37,26 +37,58 @@ extern signed int http_rest_network_handler(struct http_request *request);
 extern signed int http_rest_net_names_handler(struct http_request *request);
 
 /**
- * @brief REST handler for setting the password for the default network.
+ * @brief REST callbacks for setting the password for the default network.
  */
-extern signed int http_rest_net_passwd_handler(struct http_request *request);
+extern const struct http_method_handlers http_rest_net_passwd_methods;
 
 /**
- * @brief REST handler for GPIO toggling.
+ * @brief REST callbacks for the list of enabled GPIO's.
  */
-extern signed int http_rest_gpio_handler(struct http_request *request);
+extern const struct http_method_handlers http_rest_gpios_methods;
 
 /**
- * @brief REST handler for version information.
+ * @brief REST callbacks for GPIO toggling.
  */
-extern signed int http_rest_version_handler(struct http_request *request);
+extern const struct http_method_handlers http_rest_gpio_methods;
 
 /**
- * @brief Rest handler for memory info.
+ * @brief Handler for the GPIO WebSocket.
  */
-extern signed int http_rest_mem_handler(struct http_request *request);
+extern signed int http_rest_gpio_ws_handler(struct http_request *request);
+
+/**
+ * @brief REST callbacks for version information.
+ */
+extern const struct http_method_handlers http_rest_version_methods;
+
+/**
+ * @brief Rest callbacks for memory info.
+ */
+extern const struct http_method_handlers http_rest_mem_methods;
+
+/**
+ * @brief REST callbacks for response scheduler statistics.
+ */
+extern const struct http_method_handlers http_rest_sched_methods;
+
+/**
+ * @brief REST callbacks for request latency statistics.
+ */
+extern const struct http_method_handlers http_rest_latency_methods;
+
+/**
+ * @brief REST callbacks for the access log.
+ */
+extern const struct http_method_handlers http_rest_log_methods;
+
+/**
+ * @brief REST callbacks for running several requests at once.
+ */
+extern const struct http_method_handlers http_rest_batch_methods;
 
 //General REST functions.
 extern bool rest_init(void);
+extern void http_rest_gpio_notify(unsigned char gpio);
+extern void http_rest_net_names_refresh(bool enable);
 
 #endif
@@ -0,0 +1,96 @@
+/**
+ * @file sched.c
+ *
+ * @brief REST interface for getting response scheduler statistics.
+ * 
+ * Maps `/rest/fw/sched` to a JSON object with an object per priority
+ * class.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "osapi.h"
+#include "c_types.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "tools/json-gen.h"
+#include "slighttp/http.h"
+#include "slighttp/http-handler.h"
+#include "slighttp/http-sched.h"
+#include "slighttp/http-admit.h"
+
+/**
+ * @brief Create the response.
+ * 
+ * @param request Request to respond to..
+ * @return Size of the response.
+ */
+static signed int create_get_response(struct http_request *request)
+{
+	struct http_sched_stats *stats;
+	unsigned char class;
+	char *response = NULL;
+	char *object;
+	char *pair;
+	
+    debug("Creating scheduler REST response.\n");
+
+	if (request->response.message)
+	{
+		warn("Message is already set.\n");
+		return(os_strlen(request->response.message));
+	}
+	for (class = 0; class < HTTP_SCHED_CLASSES; class++)
+	{
+		stats = &http_sched_stats[class];
+		object = json_add_number(NULL, "depth", stats->depth);
+		object = json_add_number(object, "max_depth", stats->max_depth);
+		object = json_add_number(object, "served", stats->served);
+		object = json_add_number(object, "avg_wait",
+							stats->served ? stats->total_wait / stats->served : 0);
+		object = json_add_number(object, "max_wait", stats->max_wait);
+		pair = json_create_pair((char *)http_sched_class_names[class], object, false);
+		db_free(object);
+		response = json_add_to_object(response, pair);
+		db_free(pair);
+	}
+	//Refused requests.
+	object = json_add_number(NULL, "heap", http_admit_shed.heap);
+	object = json_add_number(object, "queue", http_admit_shed.queue);
+	object = json_add_number(object, "connections", http_admit_shed.connections);
+	object = json_add_number(object, "open", http_admit_connections);
+	object = json_add_number(object, "evicted", http_admit_shed.evicted);
+	object = json_add_number(object, "timeouts", tcp_timeouts);
+	pair = json_create_pair("shed", object, false);
+	db_free(object);
+	response = json_add_to_object(response, pair);
+	db_free(pair);
+	request->response.message = response;
+	return(os_strlen(request->response.message));
+}
+
+/**
+ * @brief REST callbacks for scheduler statistics.
+ */
+const struct http_method_handlers http_rest_sched_methods =
+{
+	.get = create_get_response,
+	.put = NULL,
+	.free = NULL
+};
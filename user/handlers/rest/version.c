@@ -73,23 +73,11 @@ static signed int create_get_response(struct http_request *request)
 }
 
 /**
- * @brief REST handler to get/set the default network.
- *
- * @param request The request that we're handling.
- * @return Bytes send.
+ * @brief REST callbacks for version info.
  */
-signed int http_rest_version_handler(struct http_request *request)
+const struct http_method_handlers http_rest_version_methods =
 {
-	if (!request)
-	{
-		warn("Empty request.\n");
-		return(RESPONSE_DONE_ERROR);
-	}
-	if (os_strncmp(request->uri, "/rest/fw/version\0", 17) != 0)
-    {
-		debug("REST version handler will not handle request.\n"); 
-		return(RESPONSE_DONE_CONTINUE);
-    }
-	
-	return(http_simple_GET_PUT_handler(request, create_get_response, NULL, NULL));
-}
+	.get = create_get_response,
+	.put = NULL,
+	.free = NULL
+};
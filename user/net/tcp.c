@@ -37,7 +37,6 @@
 #include "mem.h"
 #include "user_config.h"
 #include "driver/uart.h"
-#include "net.h"
 #include "tcp.h"
 
 /**
@@ -54,6 +53,34 @@ static unsigned char n_tcp_connections;
  * @brief Doubly-linked list of active connections.
  */
 static struct tcp_connection *tcp_connections = NULL;
+/**
+ * @brief Number of connections currently sending.
+ */
+static unsigned char tcp_in_flight = 0;
+/**
+ * @brief Number of connections closed because they timed out.
+ */
+unsigned long tcp_timeouts = 0;
+/**
+ * @brief Timer for the time out sweep.
+ */
+static os_timer_t sweep_timer;
+/**
+ * @brief First connection waiting for its turn to send.
+ */
+static struct tcp_connection *tcp_wait_first = NULL;
+/**
+ * @brief Last connection waiting for its turn to send.
+ */
+static struct tcp_connection *tcp_wait_last = NULL;
+/**
+ * @brief Queued sends, taken from here instead of the heap.
+ */
+static struct tcp_send_item tcp_send_items[TCP_SEND_ITEMS];
+/**
+ * @brief First unused item in #tcp_send_items.
+ */
+static struct tcp_send_item *tcp_free_items = NULL;
 
 //Forward declaration of callback functions.
 static void tcp_connect_cb(void *arg);
@@ -294,6 +321,154 @@ void tcp_print_connection_status(void)
 	}
 }
 
+/**
+ * @brief Hand data to the SDK for sending.
+ * 
+ * @param connection Connection used for sending the data.
+ * @param data Pointer to the data to send.
+ * @param size Length of data in bytes.
+ * @return true on success, false otherwise.
+ */
+static bool start_send(struct tcp_connection *connection, char *data, size_t size)
+{
+	signed char ret;
+	
+#ifdef DEBUG
+	uart0_tx_buffer((unsigned char *)data, size);
+#endif //DEBUG
+	if (connection->conn)
+	{
+		ret = espconn_send(connection->conn, (unsigned char*)data, size);
+		debug(" Send status %d: ", ret);
+#ifdef DEBUG
+		print_status(ret);
+#endif //DEBUG
+		if (!ret)
+		{
+			tcp_in_flight++;
+			connection->sending = true;
+			return(true);
+		}
+	}
+	else
+	{
+		warn(" Connection is empty.\n");
+	}
+	debug(" Send returned an error status.\n");
+	return(false);
+}
+
+/**
+ * @brief Put a connection at the end of the line of connections waiting to send.
+ * 
+ * @param connection The connection.
+ */
+static void wait_for_slot(struct tcp_connection *connection)
+{
+	if (connection->waiting)
+	{
+		return;
+	}
+	debug(" Connection %p waiting to send.\n", connection);
+	connection->waiting = true;
+	connection->wait_next = NULL;
+	if (tcp_wait_last)
+	{
+		tcp_wait_last->wait_next = connection;
+	}
+	else
+	{
+		tcp_wait_first = connection;
+	}
+	tcp_wait_last = connection;
+}
+
+/**
+ * @brief Remove a connection from the line of connections waiting to send.
+ * 
+ * @param connection The connection.
+ */
+static void stop_waiting(struct tcp_connection *connection)
+{
+	struct tcp_connection **link = &tcp_wait_first;
+	struct tcp_connection *prev = NULL;
+	
+	while (*link)
+	{
+		if (*link == connection)
+		{
+			*link = connection->wait_next;
+			if (tcp_wait_last == connection)
+			{
+				tcp_wait_last = prev;
+			}
+			break;
+		}
+		prev = *link;
+		link = &(*link)->wait_next;
+	}
+	connection->waiting = false;
+	connection->wait_next = NULL;
+}
+
+/**
+ * @brief Take an item from the free list.
+ * 
+ * @return The item, or NULL if all are in use.
+ */
+static struct tcp_send_item *get_item(void)
+{
+	struct tcp_send_item *item = tcp_free_items;
+	
+	if (item)
+	{
+		tcp_free_items = item->next;
+	}
+	return(item);
+}
+
+/**
+ * @brief Put an item back on the free list.
+ * 
+ * @param item The item.
+ */
+static void put_item(struct tcp_send_item *item)
+{
+	item->next = tcp_free_items;
+	tcp_free_items = item;
+}
+
+/**
+ * @brief Send the first queued data of waiting connections, while there are free slots.
+ */
+static void send_next(void)
+{
+	struct tcp_connection *connection;
+	struct tcp_send_item *item;
+	
+	while ((tcp_in_flight < TCP_MAX_IN_FLIGHT) && (tcp_wait_first))
+	{
+		connection = tcp_wait_first;
+		stop_waiting(connection);
+		item = connection->pending;
+		if (!item)
+		{
+			continue;
+		}
+		connection->pending = item->next;
+		debug(" Sending %d queued bytes on %p.\n", item->size, connection);
+		if (!start_send(connection, item->data, item->size))
+		{
+			error(" Could not send queued data.\n");
+			/* The sent call back will not come, and the rest of the data
+			 * makes no sense without this, so have the connection closed.
+			 * Remaining items are freed with the connection. */
+			tcp_expire(connection);
+		}
+		put_item(item);
+	}
+}
+
 /**
  * @brief Internal callback for when a new connection has been made.
  * 
@@ -324,6 +499,7 @@ static void tcp_connect_cb(void *arg)
 	//Nothing's happening.
 	connection->sending = false;
 	connection->closing = false;
+	connection->last_active = system_get_time();
 	
 	//Save connection addresses.
 	os_memcpy(connection->local_ip, conn->proto.tcp->local_ip, 4);
@@ -383,7 +559,8 @@ static void tcp_reconnect_cb(void *arg, sint8 err)
 		connection->callback_data.arg = arg;
 		if (connection->sending)
 		{
-			net_sending = false;
+			tcp_in_flight--;
+			connection->sending = false;
 		}
 		
 		debug("Handling as disconnect.\n");
@@ -402,6 +579,8 @@ static void tcp_reconnect_cb(void *arg, sint8 err)
 			debug(" No one is listening.\n");
 		}
 		tcp_free(connection);
+		//Let someone else have the slot.
+		send_next();
 		debug("Leaving TCP reconnect call back (%p).\n", conn);
 		return;
 	}
@@ -439,7 +618,8 @@ static void tcp_disconnect_cb(void *arg)
 		//Reset sending state if connection was sending.
 		if (connection->sending)
 		{
-			net_sending = false;
+			tcp_in_flight--;
+			connection->sending = false;
 		}
 
 		if (listening_connection)
@@ -456,6 +636,8 @@ static void tcp_disconnect_cb(void *arg)
 			debug(" No one is listening.\n");
 		}
 		tcp_free(connection);
+		//Let someone else have the slot.
+		send_next();
 		debug("Leaving TCP disconnect call back (%p).\n", conn);
 		return;
 	}
@@ -532,6 +714,7 @@ static void tcp_recv_cb(void *arg, char *data, unsigned short length)
 		connection->callback_data.arg = arg;
 		connection->callback_data.data = data;
 		connection->callback_data.length = length;
+		connection->last_active = system_get_time();
 
 		if (listening_connection)
 		{
@@ -571,8 +754,26 @@ static void tcp_sent_cb(void *arg)
 
 	if (connection)
 	{
-		net_sending = false;
-		connection->sending = false;
+		connection->last_active = system_get_time();
+		if (connection->sending)
+		{
+			tcp_in_flight--;
+			connection->sending = false;
+		}
+		//Get back in line, if there is more to send.
+		if (connection->pending)
+		{
+			wait_for_slot(connection);
+		}
+		send_next();
+		//Only tell the user, when everything has been sent.
+		if ((connection->sending) || (connection->pending))
+		{
+			debug(" Still %s queued data.\n",
+				  connection->sending ? "sending" : "waiting with");
+			debug("Leaving TCP sent call back (%p).\n", conn);
+			return;
+		}
 		//Clear previous data.
 		os_memset(&connection->callback_data, 0, sizeof(struct tcp_callback_data));
 		//Set new data
@@ -705,9 +906,10 @@ bool tcp_listen(unsigned int port,
 #endif
 	if (ret == ESPCONN_OK)
 	{
-		debug(" Setting connection time out to 60 secs...");
-		//Set time out for all connections.
-		ret = espconn_regist_time(conn, 60, 0);
+		debug(" Setting connection time out to 7200 secs...");
+		/* The sweep enforces the time outs set by the user, this is only
+		 * a back stop. The SDK only counts received data as activity. */
+		ret = espconn_regist_time(conn, 7200, 0);
 	#ifdef DEBUG
 		print_status(ret);
 	#endif
@@ -723,6 +925,44 @@ bool tcp_listen(unsigned int port,
     return(true);
 }
 
+/**
+ * @brief Close connections that have timed out, or are expired.
+ * 
+ * Called by a timer, since connections can not be closed from inside
+ * the espconn call backs.
+ * 
+ * @param arg Not used.
+ */
+static void sweep(void *arg)
+{
+	struct tcp_connection *connection = tcp_connections;
+	struct tcp_connection *next;
+	uint32 now = system_get_time();
+	
+	while (connection)
+	{
+		//The connection may be gone after closing it.
+		next = connection->next;
+		if ((!connection->callbacks) && (!connection->closing))
+		{
+			if (connection->expired)
+			{
+				debug("Closing expired connection %p.\n", connection);
+				tcp_disconnect(connection);
+			}
+			else if ((connection->timeout) &&
+					 (((now - connection->last_active) / 1000) >= connection->timeout))
+			{
+				warn("Connection %p timed out after %d ms.\n", connection,
+					 connection->timeout);
+				tcp_timeouts++;
+				tcp_disconnect(connection);
+			}
+		}
+		connection = next;
+	}
+}
+
 /**
  * @brief Initialise TCP networking.
  * 
@@ -730,6 +970,8 @@ bool tcp_listen(unsigned int port,
  */
 bool init_tcp(void)
 {
+	unsigned char i;
+	
     debug("TCP init.\n");
     if (tcp_connections != NULL)
     {
@@ -740,6 +982,17 @@ bool init_tcp(void)
     //No open connections.
     n_tcp_connections = 0;
     tcp_connections = NULL;
+    //All send items are free.
+    tcp_free_items = NULL;
+    for (i = 0; i < TCP_SEND_ITEMS; i++)
+    {
+		put_item(&tcp_send_items[i]);
+	}
+    
+    //Check for time outs.
+    os_timer_disarm(&sweep_timer);
+    os_timer_setfn(&sweep_timer, (os_timer_func_t *)sweep, NULL);
+    os_timer_arm(&sweep_timer, TCP_SWEEP_INTERVAL, 1);
     
 	return(true);
 }
@@ -796,6 +1049,12 @@ struct tcp_connection *tcp_get_connections(void)
 /** 
  * @brief Send TCP data.
  * 
+ * If the connection is already sending, or #TCP_MAX_IN_FLIGHT
+ * connections are sending, the data is queued on the connection. *The
+ * data must stay around until the sent callback is called*, which
+ * happens when all queued data of the connection has been sent. At most
+ * #TCP_SEND_ITEMS sends can be queued on all connections together.
+ * 
  * @param connection Connection used for sending the data.
  * @param data Pointer to the data to send.
  * @param size Length of data in bytes.
@@ -804,39 +1063,40 @@ struct tcp_connection *tcp_get_connections(void)
  */
 bool tcp_send(struct tcp_connection *connection, char *data, size_t size)
 {
-	signed char ret;
+	struct tcp_send_item *item;
+	struct tcp_send_item **last;
 	
     debug("Sending %d bytes of TCP data (%p using %p),\n", size, data, connection);
 	debug(" espconn pointer %p.\n", connection->conn);
 	
-	if ((connection->sending) || (net_sending))
+	if (!connection->conn)
 	{
-		error(" Still sending something else.\n");
+		warn(" Connection is empty.\n");
 		return(false);
-	}    
-#ifdef DEBUG
-	uart0_tx_buffer((unsigned char *)data, size);
-#endif //DEBUG
-	if (connection->conn)
+	}
+	//Send right away if the connection is idle, and there is a free slot.
+	if ((!connection->sending) && (!connection->pending) &&
+		(tcp_in_flight < TCP_MAX_IN_FLIGHT))
 	{
-		net_sending = true;
-		connection->sending = true;
-		ret = espconn_send(connection->conn, (unsigned char*)data, size);
-		debug(" Send status %d: ", ret);
-#ifdef DEBUG
-		print_status(ret);
-#endif //DEBUG
-		if (!ret)
-		{
-			return(true);
-		}
+		return(start_send(connection, data, size));
 	}
-	else
+	debug(" Queueing data, %d connections sending.\n", tcp_in_flight);
+	item = get_item();
+	if (!item)
 	{
-		warn(" Connection is empty.\n");
+		error(" No free items to queue the data.\n");
+		return(false);
 	}
-	debug(" Send returned an error status.\n");
-	return(false);
+	item->data = data;
+	item->size = size;
+	item->next = NULL;
+	for (last = &connection->pending; *last; last = &(*last)->next);
+	*last = item;
+	if (!connection->sending)
+	{
+		wait_for_slot(connection);
+	}
+	return(true);
 }
 
 /**
@@ -857,6 +1117,89 @@ void tcp_disconnect(struct tcp_connection *connection)
 #endif
 }
 
+/**
+ * @brief Set the time a connection may be inactive.
+ * 
+ * The time starts now, and is reset every time data is received or
+ * sent.
+ * 
+ * @param connection The connection.
+ * @param timeout Time in ms, 0 for no limit.
+ */
+void tcp_set_timeout(struct tcp_connection *connection, uint32 timeout)
+{
+	debug("Connection %p time out %d ms.\n", connection, timeout);
+	connection->timeout = timeout;
+	connection->last_active = system_get_time();
+}
+
+/**
+ * @brief Have a connection closed by the next sweep.
+ * 
+ * Use this to close a connection from inside a call back.
+ * 
+ * @param connection The connection.
+ */
+void tcp_expire(struct tcp_connection *connection)
+{
+	debug("Expiring connection %p.\n", connection);
+	connection->expired = true;
+}
+
+/**
+ * @brief Find the connection that has been inactive the longest.
+ * 
+ * Listening, closing, and expired connections are skipped.
+ * 
+ * @return The connection, or NULL if there is none.
+ */
+struct tcp_connection *tcp_least_active(void)
+{
+	struct tcp_connection *connection;
+	struct tcp_connection *ret = NULL;
+	uint32 now = system_get_time();
+	
+	for (connection = tcp_connections; connection;
+		 connection = connection->next)
+	{
+		if ((connection->callbacks) || (connection->closing) ||
+			(connection->expired))
+		{
+			continue;
+		}
+		if ((!ret) ||
+			((now - connection->last_active) > (now - ret->last_active)))
+		{
+			ret = connection;
+		}
+	}
+	return(ret);
+}
+
+/**
+ * @brief Stop receiving data on a connection.
+ * 
+ * The data stays with the client, until #tcp_unhold is called.
+ * 
+ * @param connection The connection.
+ */
+void tcp_hold(struct tcp_connection *connection)
+{
+	debug("Holding received data (%p).\n", connection);
+	espconn_recv_hold(connection->conn);
+}
+
+/**
+ * @brief Start receiving data on a connection again.
+ * 
+ * @param connection The connection.
+ */
+void tcp_unhold(struct tcp_connection *connection)
+{
+	debug("Resuming received data (%p).\n", connection);
+	espconn_recv_unhold(connection->conn);
+}
+
 /** 
  * @brief Free up data structures used by a connection.
  * 
@@ -878,6 +1221,18 @@ void tcp_free(struct tcp_connection *connection)
 		{
 			warn(" User data not NULL.\n");
 		}
+		//Drop data that was never sent.
+		if (connection->waiting)
+		{
+			stop_waiting(connection);
+		}
+		while (connection->pending)
+		{
+			struct tcp_send_item *item = connection->pending;
+			
+			connection->pending = item->next;
+			put_item(item);
+		}
 		//Remove connection from, the list of active connections.
 		debug(" Unlinking.\n");
 		DL_LIST_UNLINK(connection, connections);
@@ -29,9 +29,49 @@
 #include "espconn.h"
 #include "tools/dl_list.h"
 
+#ifndef TCP_MAX_IN_FLIGHT
+/**
+ * @brief Maximum number of connections sending at the same time.
+ */
+#define TCP_MAX_IN_FLIGHT 3
+#endif
+
+#ifndef TCP_SEND_ITEMS
+/**
+ * @brief Number of sends that can be queued, on all connections together.
+ */
+#define TCP_SEND_ITEMS 8
+#endif
+
+#ifndef TCP_SWEEP_INTERVAL
+/**
+ * @brief Time in ms between checks for connections that have timed out.
+ */
+#define TCP_SWEEP_INTERVAL 1000
+#endif
+
 //Forward declarations.
 struct tcp_connection;
 
+/**
+ * @brief Data waiting to be sent on a connection.
+ */
+struct tcp_send_item
+{
+	/**
+	 * @brief Pointer to the data.
+	 */
+	char *data;
+	/**
+	 * @brief Size of the data.
+	 */
+	size_t size;
+	/**
+	 * @brief Next item in the queue, or in the free list.
+	 */
+	struct tcp_send_item *next;
+};
+
 /**
  * @brief Data used by the callback functions.
  * 
@@ -149,6 +189,34 @@ struct tcp_connection
      * @brief Is the connection closing.
      */
     bool closing;
+    /**
+     * @brief Set when the connection is to be closed by the next sweep.
+     */
+    bool expired;
+    /**
+     * @brief Set when the connection has been refused, until the refusal is sent.
+     */
+    bool refused;
+    /**
+     * @brief Time of the last connect, receive, or sent callback in µs.
+     */
+    uint32 last_active;
+    /**
+     * @brief Time in ms the connection may be inactive, 0 for no limit.
+     */
+    uint32 timeout;
+    /**
+     * @brief Data waiting to be sent, oldest first.
+     */
+    struct tcp_send_item *pending;
+    /**
+     * @brief Is the connection waiting for its turn to send.
+     */
+    bool waiting;
+    /**
+     * @brief Next connection waiting for its turn to send.
+     */
+    struct tcp_connection *wait_next;
     /**
      * @brief A pointer for the user, never touched.
      */
@@ -160,6 +228,7 @@ struct tcp_connection
 };
 
 extern const char *state_names[];
+extern unsigned long tcp_timeouts;
 
 extern void tcp_print_connection_status(void);
 extern void tcp_free(struct tcp_connection *connection);
@@ -170,6 +239,12 @@ extern bool tcp_listen(unsigned int port, tcp_callback connect_cb,
                                 tcp_callback sent_cb);
 extern bool tcp_send(struct tcp_connection *connection, char *data, size_t size);
 extern void tcp_disconnect(struct tcp_connection *connection);
+extern void tcp_set_timeout(struct tcp_connection *connection,
+							uint32 timeout);
+extern void tcp_expire(struct tcp_connection *connection);
+extern struct tcp_connection *tcp_least_active(void);
+extern void tcp_hold(struct tcp_connection *connection);
+extern void tcp_unhold(struct tcp_connection *connection);
 extern bool init_tcp(void);
 extern bool tcp_stop(unsigned int port);
 extern struct tcp_connection *tcp_get_connections(void);
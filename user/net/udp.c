@@ -37,7 +37,6 @@
 #include "mem.h"
 #include "user_config.h"
 #include "driver/uart.h"
-#include "net.h"
 #include "udp.h"
 
                   
@@ -207,7 +206,6 @@ static void udp_sent_cb(void *arg)
 
 	if (connection)
 	{
-		net_sending = false;
 		connection->sending = false;
 		//Clear previous data.
 		os_memset(&connection->callback_data, 0, sizeof(struct udp_callback_data));
@@ -401,7 +399,7 @@ bool db_udp_send(struct udp_connection *connection, char *data, size_t size)
     debug("Sending %d bytes of UDP data (%p using %p),\n", size, data, connection);
 	debug(" espconn pointer %p.\n", connection->conn);
 	
-	if ((connection->sending) || (net_sending))
+	if (connection->sending)
 	{
 		error(" Still sending something else.\n");
 		return(false);
@@ -411,7 +409,6 @@ bool db_udp_send(struct udp_connection *connection, char *data, size_t size)
 #endif //DEBUG
 	if (connection->conn)
 	{
-		net_sending = true;
 		connection->sending = true;
 		return(espconn_send(connection->conn, (unsigned char*)data, size));
 	}
@@ -0,0 +1,163 @@
+/** @file http-admit.c
+ *
+ * @brief Admission control for new connections.
+ *
+ * New connections are refused while the free heap is low, too many
+ * responses are waiting in the scheduler, or too many connections are
+ * open. When too many connections are open, the least active one is
+ * closed to make room, if it has been idle for a while. No request data is
+ * allocated for a refused connection. When the request arrives, a fixed
+ * 503 response is sent, and the connection is closed when it has been
+ * sent.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "net/tcp.h"
+#include "http.h"
+#include "http-response.h"
+#include "http-sched.h"
+#include "http-admit.h"
+
+/**
+ * @brief The whole response to a refused request.
+ */
+#define HTTP_ADMIT_RESPONSE HTTP_STATUS_503 HTTP_HEADERS_FIXED \
+							"Retry-After: " HTTP_ADMIT_RETRY_AFTER "\r\n" \
+							"Content-Length: 0\r\n\r\n"
+
+/**
+ * @brief The response to a refused request.
+ * 
+ * Stays around until it has been sent, as #tcp_send needs.
+ */
+static char refused_response[] = HTTP_ADMIT_RESPONSE;
+
+/**
+ * @brief Number of refused requests, by reason.
+ */
+struct http_admit_counters http_admit_shed;
+
+/**
+ * @brief Number of open connections.
+ */
+unsigned char http_admit_connections = 0;
+
+/**
+ * @brief Make room by closing the least active connection.
+ * 
+ * Only connections that have been idle for #HTTP_ADMIT_EVICT_IDLE ms
+ * are closed.
+ * 
+ * @param connection The new connection, that is never closed.
+ * @return True if a connection is closing.
+ */
+static bool evict(struct tcp_connection *connection)
+{
+	struct tcp_connection *victim;
+	
+	victim = tcp_least_active();
+	if ((!victim) || (victim == connection) ||
+		(((system_get_time() - victim->last_active) / 1000) < HTTP_ADMIT_EVICT_IDLE))
+	{
+		return(false);
+	}
+	warn("Evicting idle connection %p.\n", victim);
+	http_admit_shed.evicted++;
+	//It is closed by the time out sweep.
+	tcp_expire(victim);
+	return(true);
+}
+
+/**
+ * @brief Initialise admission control.
+ */
+void http_admit_init(void)
+{
+	os_memset(&http_admit_shed, 0, sizeof(struct http_admit_counters));
+}
+
+/**
+ * @brief Decide whether to serve a new connection.
+ * 
+ * Counts the connection, and the reason if it is refused.
+ * 
+ * @param connection The new connection.
+ * @return True if the connection is to be served.
+ */
+bool http_admit(struct tcp_connection *connection)
+{
+	unsigned short depth = 0;
+	unsigned char class;
+	
+	//Count this one.
+	if ((++http_admit_connections > HTTP_ADMIT_MAX_CONNECTIONS) &&
+		(!evict(connection)))
+	{
+		warn("Refusing %p, %d connections open.\n", connection,
+			 http_admit_connections);
+		http_admit_shed.connections++;
+		return(false);
+	}
+	if (system_get_free_heap_size() < HTTP_ADMIT_MIN_HEAP)
+	{
+		warn("Refusing %p, %d bytes of free heap.\n", connection,
+			 system_get_free_heap_size());
+		http_admit_shed.heap++;
+		//Free some memory for the next one.
+		evict(connection);
+		return(false);
+	}
+	for (class = 0; class < HTTP_SCHED_CLASSES; class++)
+	{
+		depth += http_sched_stats[class].depth;
+	}
+	if (depth > HTTP_ADMIT_MAX_QUEUE)
+	{
+		warn("Refusing %p, %d responses waiting.\n", connection, depth);
+		http_admit_shed.queue++;
+		return(false);
+	}
+	return(true);
+}
+
+/**
+ * @brief Answer a refused request with status 503.
+ * 
+ * @param connection The connection of the request.
+ */
+void http_admit_refuse(struct tcp_connection *connection)
+{
+	debug("Sending 503 to refused connection %p.\n", connection);
+	//Later segments of the request are ignored.
+	connection->refused = false;
+	if (connection->closing)
+	{
+		return;
+	}
+	if (!tcp_send(connection, refused_response,
+				  HTTP_CONST_SIZE(HTTP_ADMIT_RESPONSE)))
+	{
+		tcp_expire(connection);
+	}
+}
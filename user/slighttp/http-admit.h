@@ -0,0 +1,95 @@
+/** @file http-admit.h
+ *
+ * @brief Admission control for new connections.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#ifndef HTTP_ADMIT_H
+#define HTTP_ADMIT_H
+
+#include "c_types.h"
+#include "net/tcp.h"
+
+#ifndef HTTP_ADMIT_MIN_HEAP
+/**
+ * @brief Free heap in bytes needed to accept a new request.
+ */
+#define HTTP_ADMIT_MIN_HEAP 8192
+#endif
+
+#ifndef HTTP_ADMIT_MAX_QUEUE
+/**
+ * @brief Responses waiting in the scheduler, before new requests are refused.
+ */
+#define HTTP_ADMIT_MAX_QUEUE 8
+#endif
+
+#ifndef HTTP_ADMIT_MAX_CONNECTIONS
+/**
+ * @brief Open connections, before new requests are refused.
+ */
+#define HTTP_ADMIT_MAX_CONNECTIONS 5
+#endif
+
+#ifndef HTTP_ADMIT_EVICT_IDLE
+/**
+ * @brief Time in ms a connection must be idle, before it can be evicted.
+ */
+#define HTTP_ADMIT_EVICT_IDLE 1000
+#endif
+
+#ifndef HTTP_ADMIT_RETRY_AFTER
+/**
+ * @brief Seconds a refused client is asked to wait before trying again.
+ */
+#define HTTP_ADMIT_RETRY_AFTER "2"
+#endif
+
+/**
+ * @brief Number of refused requests, by reason.
+ */
+struct http_admit_counters
+{
+	/**
+	 * @brief Refused because of low free heap.
+	 */
+	unsigned long heap;
+	/**
+	 * @brief Refused because too many responses were waiting.
+	 */
+	unsigned long queue;
+	/**
+	 * @brief Refused because too many connections were open.
+	 */
+	unsigned long connections;
+	/**
+	 * @brief Idle connections closed to make room.
+	 */
+	unsigned long evicted;
+};
+
+extern struct http_admit_counters http_admit_shed;
+extern unsigned char http_admit_connections;
+
+extern void http_admit_init(void);
+extern bool http_admit(struct tcp_connection *connection);
+extern void http_admit_refuse(struct tcp_connection *connection);
+
+#endif //HTTP_ADMIT_H
@@ -34,46 +34,8 @@
 #include "http-common.h"
 
 /**
- * @brief Print a Common Log Format message to the console.
- * 
- * Log access to the web server to console in a standardized text file format:
- * 
- *  host ident authuser date request status bytes
- * 
- * or:
- * 
- *  127.0.0.1 user-identifier frank [10/Oct/2000:13:55:36 -0700] "GET /apache_pb.gif HTTP/1.0" 200 2326
- * 
- * See [CLF](https://en.wikipedia.org/wiki/Common_Log_Format).
+ * @brief Names of the request methods, indexed by enum #request_types.
  */
-void http_print_clf_status(struct http_request *request)
-{
-    char *unknown = "-";
-    
-	db_printf(IPSTR, IP2STR(request->connection->remote_ip));
-	db_printf(" %s %s %s", unknown, unknown, unknown);
-	db_printf(" \"");
-	switch(request->type)
-	{
-		case HTTP_OPTIONS: db_printf("OPTIONS");
-						   break;
-		case HTTP_GET: db_printf("GET");
-					   break;
-    	case HTTP_HEAD: db_printf("HEAD");
-						break;
-    	case HTTP_POST: db_printf("POST");
-						break;
-    	case HTTP_PUT: db_printf("PUT");
-					   break;
-    	case HTTP_DELETE: db_printf("DELETE");
-						  break;
-    	case HTTP_TRACE: db_printf("TRACE");
-						 break;
-    	case HTTP_CONNECT: db_printf("CONNECT");
-						   break;
-    	default: db_printf("-");
-    }
-    db_printf(" %s HTTP/%s\" %d %ld\n", request->uri, request->version, 
-			  request->response.status_code, request->response.message_size);
-}
+const char *http_method_names[] = {"-", "OPTIONS", "GET", "HEAD", "POST",
+								   "PUT", "DELETE", "TRACE", "CONNECT"};
 
@@ -78,6 +78,6 @@
                                         }\
                                     } while(0)
 
-extern void http_print_clf_status(struct http_request *request);
+extern const char *http_method_names[];
 
 #endif //HTTP_COMMON_H
@@ -1,6 +1,6 @@
 /** @file http-handler.c
  *
- * @brief Routines for request handler registration.
+ * @brief Routing of requests to handlers.
  *
  * @copyright
  * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
@@ -22,153 +22,320 @@
  * MA 02110-1301, USA.
  */
 #include "user_config.h"
-#include "tools/dl_list.h"
 #include "tools/strxtra.h"
 #include "http-response.h"
-#include "http-handler.h"
 #include "http-mime.h"
+#include "http-handler.h"
+#include "http-common.h"
+#include "http-sched.h"
+#include "http-latency.h"
 
 /**
- * @brief Struct to keep info on a registered handler.
+ * @brief Start of the route table, set by the linker.
  */
-struct http_handler_entry
-{
-	/**
-	 * @brief Root URI that the handler will work with.
-	 */
-	char *uri;
-	/**
-	 * @brief Handler callbacks.
-	 */
-	http_handler_callback handler;
-	/**
-     * @brief Pointers for the prev and next entry in the list.
-     */
-    DL_LIST_CREATE(struct http_handler_entry);
-};
+extern const struct http_route _http_routes_start[];
+/**
+ * @brief End of the route table, set by the linker.
+ */
+extern const struct http_route _http_routes_end[];
+
+/**
+ * @brief Modes of the routes in use.
+ */
+static uint32 routes_modes = HTTP_ROUTES_NORMAL;
+
+/**
+ * @brief No entry in #route_parent.
+ */
+#define HTTP_ROUTE_NONE 0xff
 
 /**
- * @brief List to keep track of handlers.
+ * @brief Table positions of the routes in use, sorted by URI.
+ * 
+ * Routes with the same URI are kept in table order. The URI of a prefix
+ * route is sorted without the trailing `*`.
+ */
+static unsigned char route_index[HTTP_ROUTES_MAX];
+/**
+ * @brief For each entry in #route_index, the entry of the longest prefix
+ * route that the URI of the entry starts with, or #HTTP_ROUTE_NONE.
+ */
+static unsigned char route_parent[HTTP_ROUTES_MAX];
+/**
+ * @brief For each entry in #route_index, the first entry with the same
+ * URI.
+ */
+static unsigned char route_first[HTTP_ROUTES_MAX];
+/**
+ * @brief Number of entries in #route_index.
+ */
+static unsigned char routes_indexed;
+/**
+ * @brief True when #route_index is up to date with the selected modes.
  */
-static struct http_handler_entry *response_handlers = NULL;
+static bool routes_index_valid = false;
+
 /**
- * @brief Number of registered handlers.
+ * @brief Get the route of an entry in #route_index.
  */
-static unsigned int n_handlers = 0;
+#define HTTP_INDEXED_ROUTE(i) (&_http_routes_start[route_index[(i)]])
 
 /**
- * @brief Register a handler.
+ * @brief Select the routes in use.
+ * 
+ * Routes not defined for any of the modes are skipped when looking for
+ * a handler.
  * 
- * Register functions to handle some URIs. The list of registered
- * handlers is searched from the first added handler to the last.
- * Make sure to add the most specific URIs first.
+ * @param modes Mask of modes, see #HTTP_ROUTES_NORMAL.
+ */
+void http_routes_select(uint32 modes)
+{
+	debug("Selecting routes 0x%x.\n", modes);
+	routes_modes = modes;
+	routes_index_valid = false;
+}
+
+/**
+ * @brief Compare the URI of a route to an URI.
  * 
- * @param uri The base URI that the handler will start at. Everything
- *            below this URI will be handled by this handler, except
- *            when another rule, *added before this*, will handle it.
- * @param handler Pointer to the callback.
+ * @param route The route.
+ * @param uri The URI.
+ * @param uri_size Length of the URI.
+ * @param common Number of characters known to be the same, the number
+ *               of characters that are the same is returned here.
+ * @return Less than, equal to, or greater than zero, if the URI of the
+ *         route sorts before, the same as, or after the URI.
  */
-bool http_add_handler(char *uri, http_handler_callback handler)
+static signed int route_compare(const struct http_route *route,
+								const char *uri, size_t uri_size,
+								size_t *common)
 {
-	struct http_handler_entry *handlers = response_handlers;
-	struct http_handler_entry *entry = NULL;
-	size_t uri_size = os_strlen(uri);
+	const char *route_uri = route->uri;
+	size_t size = route->size;
+	size_t i;
 	
-	//Check for stuff that is a no go.
-	debug("Adding URI handler %s.\n", uri);
-	if (!handler)
+	for (i = *common; (i < size) && (i < uri_size); i++)
 	{
-		debug("No handler.\n");
-		return(false);
+		if (route_uri[i] != uri[i])
+		{
+			*common = i;
+			return((unsigned char)route_uri[i] - (unsigned char)uri[i]);
+		}
 	}
-	if (!uri)
+	*common = i;
+	if (size < uri_size)
 	{
-		debug("No URI.\n");
-		return(false);
+		return(-1);
 	}
-	//Get mem for the entry in the list.
-	entry = db_malloc(sizeof(struct http_handler_entry), "entry http_add_handler");
-	//Add handler callbacks.
-	entry->handler = handler;
-	//Get mem for URI.
-	entry->uri = db_malloc(uri_size + 1  * sizeof(char), "entry->uri http_add_handler");
-	//Set URI.
-	debug("Copying match URI, %d bytes.\n", uri_size);
-	memcpy(entry->uri, uri, uri_size);
-	entry->uri[uri_size] = '\0';
+	return(size > uri_size);
+}
+
+/**
+ * @brief Check if an URI starts with the URI of a route.
+ * 
+ * @param route The route.
+ * @param uri The URI.
+ * @param uri_size Length of the URI.
+ * @return True if it does.
+ */
+static bool route_starts(const struct http_route *route, const char *uri,
+						 size_t uri_size)
+{
+	return((uri_size >= route->size) &&
+		   (os_strncmp(uri, route->uri, route->size) == 0));
+}
+
+/**
+ * @brief Build #route_index for the selected modes.
+ */
+static void index_routes(void)
+{
+	const struct http_route *route;
+	const struct http_route *entry;
+	unsigned char n = 0;
+	unsigned char i;
+	unsigned char j;
+	size_t common;
 	
-	if (handlers == NULL)
+	debug("Indexing routes 0x%x.\n", routes_modes);
+	for (route = _http_routes_start; route < _http_routes_end; route++)
 	{
-		response_handlers = entry;
-		entry->prev = NULL;
-		entry->next = NULL;
+		if (!(route->modes & routes_modes))
+		{
+			continue;
+		}
+		if (n >= HTTP_ROUTES_MAX)
+		{
+			error("More than %d routes, raise HTTP_ROUTES_MAX.\n",
+				  HTTP_ROUTES_MAX);
+			break;
+		}
+		//Insert after the routes with the same URI.
+		for (i = n; i > 0; i--)
+		{
+			common = 0;
+			if (route_compare(HTTP_INDEXED_ROUTE(i - 1), route->uri,
+							  route->size, &common) <= 0)
+			{
+				break;
+			}
+			route_index[i] = route_index[i - 1];
+		}
+		route_index[i] = route - _http_routes_start;
+		n++;
 	}
-	else
+	for (i = 0; i < n; i++)
 	{
-		DL_LIST_ADD_END(entry, handlers);
+		entry = HTTP_INDEXED_ROUTE(i);
+		route_first[i] = i;
+		common = 0;
+		if ((i > 0) && (route_compare(HTTP_INDEXED_ROUTE(i - 1), entry->uri,
+									  entry->size, &common) == 0))
+		{
+			route_first[i] = route_first[i - 1];
+		}
+		//The longest prefix of an URI is the closest one before it.
+		route_parent[i] = HTTP_ROUTE_NONE;
+		for (j = route_first[i]; j > 0; j--)
+		{
+			route = HTTP_INDEXED_ROUTE(j - 1);
+			if ((route->prefix) &&
+				(route_starts(route, entry->uri, entry->size)))
+			{
+				route_parent[i] = j - 1;
+				break;
+			}
+		}
 	}
-	n_handlers++;
-	debug("%d registered handlers.\n", n_handlers);
-	return(true);
+	routes_indexed = n;
+	routes_index_valid = true;
 }
 
 /**
- * @brief Remove a registered handler.
+ * @brief Get the methods handled by a route.
+ * 
+ * Method routes handle GET and HEAD if there is a `get` callback, and
+ * PUT if there is a `put` callback.
  * 
- * @param handler Pointer to a the callback.
+ * @param route The route.
+ * @return Mask of methods.
  */
-bool http_remove_handler(http_handler_callback handler)
+static unsigned short route_methods(const struct http_route *route)
 {
-	struct http_handler_entry *entry = response_handlers;
-	struct http_handler_entry *handlers = response_handlers;
+	unsigned short methods = route->methods;
 	
-	debug("Removing URI handler.\n");
-	if (!handler)
+	if (route->callbacks)
 	{
-		debug("No handler.\n");
-		return(false);
+		if (route->callbacks->get)
+		{
+			methods |= HTTP_METHODS_GET;
+		}
+		if (route->callbacks->put)
+		{
+			methods |= HTTP_METHOD(HTTP_PUT);
+		}
 	}
-	if (!handlers)
+	return(methods);
+}
+
+/**
+ * @brief Find the routes that match an URI.
+ * 
+ * Only the routes that sort before the URI can match. Of those, the
+ * closest one and the routes with the same URI are checked, then the
+ * prefix routes that the closest one starts with. These match if they
+ * are no longer than what the closest one has in common with the URI.
+ * 
+ * @param uri The URI.
+ * @param uri_size Length of the URI.
+ * @param matches The table positions of the matching routes are returned
+ *                here, in no particular order.
+ * @return Number of matching routes.
+ */
+static unsigned char find_routes(const char *uri, size_t uri_size,
+								 unsigned char *matches)
+{
+	const struct http_route *route;
+	unsigned char n = 0;
+	unsigned char low = 0;
+	unsigned char high = routes_indexed;
+	unsigned char middle;
+	unsigned char next;
+	unsigned char i;
+	unsigned char j;
+	size_t low_common = 0;
+	size_t high_common = 0;
+	size_t common;
+	
+	//Find the last route that does not sort after the URI. Routes between
+	//the bounds have what both bounds have in common with the URI.
+	while (low < high)
 	{
-		debug("No handlers registered.\n");
-		return(false);
+		middle = (low + high) / 2;
+		common = (low_common < high_common) ? low_common : high_common;
+		if (route_compare(HTTP_INDEXED_ROUTE(middle), uri, uri_size,
+						  &common) <= 0)
+		{
+			low = middle + 1;
+			low_common = common;
+		}
+		else
+		{
+			high = middle;
+			high_common = common;
+		}
 	}
-	
-	while (handlers)
+	next = low ? (low - 1) : HTTP_ROUTE_NONE;
+	while (next != HTTP_ROUTE_NONE)
 	{
-		if (handlers->handler == handler)
+		i = next;
+		route = HTTP_INDEXED_ROUTE(i);
+		next = route_parent[i];
+		if (route->size > low_common)
 		{
-			debug("Unlinking handler.\n");
-			DL_LIST_UNLINK(entry, handlers);	
-			debug("Deallocating URI.\n");
-			db_free(entry->uri);
-			debug("Deallocating handler info.\n");
-			db_free(entry);
-			n_handlers--;
-			debug("%d registered handlers.\n", n_handlers);
-			return(true);
+			continue;
+		}
+		//All routes with this URI.
+		for (j = route_first[i]; j <= i; j++)
+		{
+			route = HTTP_INDEXED_ROUTE(j);
+			if ((route->prefix) || (route->size == uri_size))
+			{
+				matches[n++] = route_index[j];
+			}
 		}
-		handlers = handlers->next;
 	}
-	warn(" Handler not fount.\n");
-	return(false);
+	return(n);
 }
 
 /**
  * @brief Find a handler for an URI.
  * 
+ * Looks up the routes matching the URI in the route index, and picks the
+ * first of them in the table, that the linker has put in order. The
+ * route of the handler is saved in the response, to be able to fall
+ * through to the next handler.
+ * 
  * @param request Pointer to the request data, only URI needs to be populated.
- * @param start_handler If not NULL, search the list only after this handler-
+ * Only handlers accepting the method of the request are used. If
+ * handlers for the URI are skipped because of the method, and only
+ * catch all handlers on the root are left, the status is set to 405.
+ * 
+ * @param start If not NULL, only look at routes after this route.
  * @return Function pointer to a handler.
  */
 http_handler_callback http_get_handler(
 	struct http_request *request,
-	http_handler_callback start_handler
+	const struct http_route *start
 )
 {
-	struct http_handler_entry *handlers = response_handlers;
-	unsigned short i = 1;
-	size_t handler_uri_length;
+	const struct http_route *route = NULL;
+	const struct http_route *match;
+	unsigned char matches[HTTP_ROUTES_MAX];
+	unsigned char n_matches;
+	unsigned char i;
+	unsigned short method;
+	unsigned short allow = 0;
 	
 	debug("Finding handler.\n");
 	if (!request)
@@ -176,101 +343,244 @@ http_handler_callback http_get_handler(
 		debug(" No request data.\n");
 		return(NULL);
 	}
+	request->response.route = NULL;
 	if (!request->uri)
 	{
 		debug(" No URI.\n");
 		return(NULL);
 	}
 	debug(" URI: %s.\n", request->uri);
-	if (!handlers)
+	if (start != NULL)
 	{
-		debug(" No handlers.\n");
-		return(NULL);
+		debug(" Starting after route %d.\n", start - _http_routes_start);
+	}
+	if (!routes_index_valid)
+	{
+		index_routes();
 	}
 
-	debug(" %d response handlers.\n", n_handlers);
-	if (start_handler != NULL)
+	n_matches = find_routes(request->uri, os_strlen(request->uri), matches);
+	method = HTTP_METHOD(request->type);
+	//The first route after start that handles the method.
+	for (i = 0; i < n_matches; i++)
 	{
-		debug(" Starting at handler %p.\n", start_handler);
-		while (handlers)
+		match = &_http_routes_start[matches[i]];
+		if (((!start) || (match > start)) && ((!route) || (match < route)) &&
+			(route_methods(match) & method))
 		{
-			if (handlers->handler == start_handler)
-			{
-				debug(" Handler %p is number %d.\n", start_handler, i);
-				i++;
-				if (i > n_handlers)
-				{
-					debug(" No more handlers.\n");
-					return(NULL);
-				}
-				handlers = handlers->next;
-				break;
-			}
-			i++;
-			handlers = handlers->next;
+			route = match;
 		}
 	}
-	
-	//Check URI, go through and stop if URIs match.
-	while (handlers)
+	//Routes before it that handle the URI, but not the method.
+	for (i = 0; i < n_matches; i++)
 	{
-		debug(" Trying handler %d, URI: %s.\n", i, handlers->uri);
-		handler_uri_length = os_strlen(handlers->uri);
-		if (handlers->uri[handler_uri_length - 1] != '*')
+		match = &_http_routes_start[matches[i]];
+		if (((start) && (match <= start)) || ((route) && (match >= route)))
 		{
-			debug(" Using strict matching.\n");
-			if (handler_uri_length != os_strlen(request->uri))
-			{
-				//Signal that length does not match.
-				debug(" URI length is not equal.\n");
-				handler_uri_length = 0;
-			}
+			continue;
 		}
-		else
+		//Prefix routes on the root are catch all, and do not signal 405.
+		if ((!match->prefix) || (match->size > 1))
 		{
-			//Dont't use the '*'.
-			handler_uri_length--;
+			allow |= route_methods(match);
 		}
-		if (handler_uri_length)
+	}
+	//A route for the URI exists, but not for the method.
+	if ((allow) && ((!route) ||
+		((route->prefix) && (route->size <= 1))))
+	{
+		debug(" Methods 0x%x allowed for %s.\n", allow, request->uri);
+		request->response.allow |= allow;
+		if (request->response.status_code < 400)
 		{
-			if (os_strncmp(handlers->uri, request->uri,
-						   handler_uri_length) == 0)
+			request->response.status_code = 405;
+		}
+	}
+	if (!route)
+	{
+		debug(" No response handler found for URI %s.\n", request->uri);
+		return(NULL);
+	}
+	debug(" URI handler %d for %s at %p.\n", route - _http_routes_start,
+		  request->uri, route->handler);
+	request->response.route = route;
+	//Per method callbacks are REST and the like.
+	request->sched_class = route->callbacks ? HTTP_SCHED_CONTROL : HTTP_SCHED_BULK;
+	return(route->handler);
+}
+
+/**
+ * @brief Get the body callback of the route of a request.
+ * 
+ * @param request The request.
+ * @return The callback, or NULL if the body is to be collected.
+ */
+http_body_callback http_get_body_callback(struct http_request *request)
+{
+	const struct http_route *route = request->response.route;
+	
+	if ((route) && (route->callbacks))
+	{
+		return(route->callbacks->body);
+	}
+	return(NULL);
+}
+
+/**
+ * @brief Get the latency statistics of a route.
+ * 
+ * The statistics are created the first time they are needed.
+ * 
+ * @param route The route.
+ * @return The statistics, or NULL if there is no memory for them.
+ */
+struct http_latency *http_route_latency(const struct http_route *route)
+{
+	if (!*route->latency)
+	{
+		*route->latency = http_latency_new(route->uri, route->order);
+	}
+	return(*route->latency);
+}
+
+/**
+ * @brief Send the `Allow` header of a 405 response.
+ * 
+ * @param request The request with the allowed methods.
+ * @return Size of data sent.
+ */
+static unsigned short http_send_allow_header(struct http_request *request)
+{
+	unsigned short ret;
+	size_t size;
+	unsigned char i;
+	
+	//Each name is sent as it is, so any set of methods fits.
+	ret = http_send(request->connection, "Allow: ", 7);
+	size = ret;
+	for (i = HTTP_OPTIONS; i <= HTTP_CONNECT; i++)
+	{
+		if (request->response.allow & HTTP_METHOD(i))
+		{
+			if (ret > size)
 			{
-				debug(" URI handlers for %s at %p.\n", request->uri,
-					  handlers->handler);
-				return(handlers->handler);
+				ret += http_send(request->connection, ", ", 2);
 			}
+			ret += http_send(request->connection, (char *)http_method_names[i],
+							 os_strlen(http_method_names[i]));
 		}
-		i++;
-		handlers = handlers->next;
 	}
-	debug(" No response handler found for URI %s.\n", request->uri);
-	return(NULL);
+	ret += http_send(request->connection, "\r\n", 2);
+	return(ret);
 }
 
+/**
+ * @brief Make a string of the value of a macro.
+ */
+#define HTTP_XSTR(VALUE) HTTP_STR(VALUE)
+/**
+ * @brief Make a string of a macro argument.
+ */
+#define HTTP_STR(VALUE) #VALUE
+
+/**
+ * @brief Define the complete response for an error status code.
+ * 
+ * Status line, headers, and message are put together by the compiler,
+ * and stored in flash. The array type fails to compile, if the length
+ * of the HTML does not match its `_LENGTH` macro.
+ */
+#define HTTP_ERROR_RESPONSE(CODE) \
+	typedef char error_##CODE##_length_check[ \
+		(HTTP_CONST_SIZE(HTTP_##CODE##_HTML) == HTTP_##CODE##_HTML_LENGTH) ? 1 : -1]; \
+	static const char error_##CODE[] ICACHE_RODATA_ATTR \
+	__attribute__((aligned(4))) = HTTP_STATUS_##CODE HTTP_HEADERS_FIXED \
+		HTTP_HEADER_CONTENT_LENGTH HTTP_XSTR(HTTP_##CODE##_HTML_LENGTH) \
+		HTTP_HEADER_CONTENT_TYPE "text/html" HTTP_HEADERS_END \
+		HTTP_##CODE##_HTML
+
+HTTP_ERROR_RESPONSE(400);
+HTTP_ERROR_RESPONSE(403);
+HTTP_ERROR_RESPONSE(404);
+HTTP_ERROR_RESPONSE(405);
+HTTP_ERROR_RESPONSE(413);
+HTTP_ERROR_RESPONSE(500);
+HTTP_ERROR_RESPONSE(501);
+HTTP_ERROR_RESPONSE(503);
+
+/**
+ * @brief A complete error response in flash.
+ * 
+ * Every member is 32 bits, since flash can only be read 32 bits at a
+ * time.
+ */
+struct http_error_response
+{
+	/**
+	 * @brief The status code.
+	 */
+	uint32 status_code;
+	/**
+	 * @brief The response.
+	 */
+	const char *response;
+	/**
+	 * @brief Size of the response.
+	 */
+	uint32 size;
+	/**
+	 * @brief Size of the status line at the start of the response.
+	 */
+	uint32 status_size;
+};
+
+/**
+ * @brief Add an error response to #error_responses.
+ */
+#define HTTP_ERROR_ENTRY(CODE) \
+	{ CODE, error_##CODE, HTTP_CONST_SIZE(error_##CODE), \
+	  HTTP_CONST_SIZE(HTTP_STATUS_##CODE) }
+
+/**
+ * @brief The complete error responses.
+ */
+static const struct http_error_response error_responses[] ICACHE_RODATA_ATTR =
+{
+	HTTP_ERROR_ENTRY(400),
+	HTTP_ERROR_ENTRY(403),
+	HTTP_ERROR_ENTRY(404),
+	HTTP_ERROR_ENTRY(405),
+	HTTP_ERROR_ENTRY(413),
+	HTTP_ERROR_ENTRY(500),
+	HTTP_ERROR_ENTRY(501),
+	HTTP_ERROR_ENTRY(503)
+};
+
 /**
  * @brief Last chance status handler.
  * 
+ * Responses for the common error status codes are sent from flash, as
+ * a single piece. Other status codes get a generic page.
+ * 
  * @param request Request to handle.
  * @return Bytes send.
  */
 signed int http_status_handler(struct http_request *request)
 {
-	size_t size = 0;
-	char str_size[5];
-	char *msg = NULL;
-	char default_msg[102];
+	const struct http_error_response *error = NULL;
+	char code[4];
+	size_t size;
 	signed int ret;
-	static bool done = false;
+	unsigned char i;
 	
 	if (!request)
 	{
 		warn("Empty request.\n");
 		return(RESPONSE_DONE_ERROR);
 	}
-	if (done)
+	//Called again when the response has been sent.
+	if (request->response.state == HTTP_STATE_DONE)
 	{
-		done = false;
 		return(RESPONSE_DONE_FINAL);
 	}
 
@@ -281,56 +591,47 @@ signed int http_status_handler(struct http_request *request)
 		debug(" Returning 404.\n");
 		request->response.status_code = 404;
 	}
-	switch (request->response.status_code)
+	for (i = 0; i < (sizeof(error_responses) / sizeof(struct http_error_response)); i++)
 	{
-		case 400:
-			size = HTTP_400_HTML_LENGTH;
-			msg = HTTP_400_HTML;
-			break;
-		case 403:
-			size = HTTP_403_HTML_LENGTH;
-			msg = HTTP_403_HTML;
-			break;
-		case 404:
-			size = HTTP_404_HTML_LENGTH;
-			msg = HTTP_404_HTML;
-			break;
-		case 405:
-			size = HTTP_405_HTML_LENGTH;
-			msg = HTTP_405_HTML;
-			break;
-		case 500:
-			size = HTTP_500_HTML_LENGTH;
-			msg = HTTP_500_HTML;
-			break;
-		case 501:
-			size = HTTP_501_HTML_LENGTH;
-			msg = HTTP_501_HTML;
+		if (error_responses[i].status_code == request->response.status_code)
+		{
+			error = &error_responses[i];
 			break;
-		default:
-			os_memcpy(default_msg, HTTP_ERROR_HTML_START, 83);
-			size = 83;
-			itoa(request->response.status_code, (char *)(default_msg + size), 10);
-			size += 3;
-			os_memcpy(default_msg + size, HTTP_ERROR_HTML_END "\0", 16);
-			size += 15;
-			msg = default_msg;
+		}
 	}
-	itoa(size, str_size, 10);
-	ret = http_send_status_line(request->connection, request->response.status_code);
-	ret += http_send_header(request->connection, "Connection", "close");
-	ret += http_send_header(request->connection, "Server", HTTP_SERVER_NAME);	
-	//Send message length.
-	ret += http_send_header(request->connection, "Content-Length", str_size);
-	ret += http_send_header(request->connection, "Content-Type", http_mime_types[MIME_HTML].type);	
-	//Send end of headers.
-	ret += http_send(request->connection, "\r\n", 2);
-	if (msg)
+	if (error)
 	{
-		ret += http_send(request->connection, msg, size);
+		if ((request->response.status_code == 405) && (request->response.allow))
+		{
+			//Put the Allow header after the status line.
+			ret = http_send_flash(request->connection, error->response,
+								  error->status_size);
+			ret += http_send_allow_header(request);
+			ret += http_send_flash(request->connection,
+								   error->response + error->status_size,
+								   error->size - error->status_size);
+		}
+		else
+		{
+			ret = http_send_flash(request->connection, error->response,
+								  error->size);
+		}
+	}
+	else
+	{
+		size = HTTP_CONST_SIZE(HTTP_ERROR_HTML_START) + 3 +
+			   HTTP_CONST_SIZE(HTTP_ERROR_HTML_END);
+		ret = http_send_status_line(request->connection, request->response.status_code);
+		ret += http_send_default_headers(request, size, MIME_HTML);
+		ret += http_send_ref(request->connection, HTTP_ERROR_HTML_START,
+							 HTTP_CONST_SIZE(HTTP_ERROR_HTML_START));
+		itoa(request->response.status_code, code, 10);
+		ret += http_send(request->connection, code, 3);
+		ret += http_send_ref(request->connection, HTTP_ERROR_HTML_END,
+							 HTTP_CONST_SIZE(HTTP_ERROR_HTML_END));
 	}
 	request->response.message_size = ret;
-	done = true;
+	request->response.state = HTTP_STATE_DONE;
 	return(ret);
 }
 
@@ -343,7 +644,8 @@ signed int http_status_handler(struct http_request *request)
  * No more than about 1300 bytes can be send.
  *
  * If any callback pointer is NULL, a request with that method is 
- * skipped.
+ * skipped. If a callback returns one of the negative RESPONSE_DONE_*
+ * values, nothing is sent, and the value is returned.
  * 
  * @param request The request that we're handling.
  * @param get_cb Callback to handle get requests.
@@ -358,7 +660,8 @@ signed int http_simple_GET_PUT_handler(
 )
 {
 	signed int ret = 0;
-	size_t msg_size = 0;
+	signed int msg_size = 0;
+	size_t bytes, buffer_free;
 		
 	if (!request)
 	{
@@ -391,6 +694,12 @@ signed int http_simple_GET_PUT_handler(
 		{
 			msg_size = put_cb(request);
 		}
+		//Let the next handler take over.
+		if (msg_size < 0)
+		{
+			debug(" Callback returned %d.\n", msg_size);
+			return(msg_size);
+		}
 		//No data.
 		if (msg_size == 0)
 		{
@@ -400,7 +709,7 @@ signed int http_simple_GET_PUT_handler(
 		request->response.message_size = 0;
 		//Send status and headers.
 		ret += http_send_status_line(request->connection, request->response.status_code);
-		ret += http_send_default_headers(request, msg_size, "json");
+		ret += http_send_default_headers(request, msg_size, MIME_JSON);
 		if (request->type == HTTP_HEAD)
 		{
 			debug("Simple GET PUT handler leaving state %d.\n", request->response.state);
@@ -419,13 +728,27 @@ signed int http_simple_GET_PUT_handler(
 		debug("Simple GET PUT handler entering state %d.\n", request->response.state);
 		if (request->response.message)
 		{
+			//Send as much as there is room for, the rest on the next call.
 			msg_size = os_strlen(request->response.message);
+			bytes = msg_size - request->response.message_size;
+			buffer_free = HTTP_SEND_BUFFER_SIZE - (request->response.send_buffer_pos - request->response.send_buffer);
+			if (bytes > buffer_free)
+			{
+				bytes = buffer_free;
+			}
 			debug(" Response: %s.\n", (char *)request->response.message);
-			ret += http_send(request->connection, request->response.message, msg_size);
+			ret += http_send_ref(request->connection,
+								 (char *)request->response.message + request->response.message_size,
+								 bytes);
+			request->response.message_size += bytes;
+			if (request->response.message_size < msg_size)
+			{
+				debug(" %d bytes of message left.\n", msg_size - request->response.message_size);
+				return(ret);
+			}
 		}
 		//We're done sending the message.
 		request->response.state = HTTP_STATE_DONE;
-		request->response.message_size = msg_size;
 		debug("Simple GET PUT handler leaving state %d.\n", request->response.state);
 		return(ret);
 	}
@@ -448,3 +771,26 @@ signed int http_simple_GET_PUT_handler(
 	debug("Simple GET PUT handler leaving state %d.\n", request->response.state);
 	return(RESPONSE_DONE_FINAL);
 }
+
+/**
+ * @brief Handler for routes defined with #HTTP_METHOD_ROUTE.
+ * 
+ * Calls the callbacks registered with the route of the request, using
+ * #http_simple_GET_PUT_handler.
+ * 
+ * @param request The request that we're handling.
+ * @return Bytes send.
+ */
+signed int http_method_handler(struct http_request *request)
+{
+	const struct http_method_handlers *callbacks;
+	
+	if ((!request) || (!request->response.route))
+	{
+		warn("Empty request.\n");
+		return(RESPONSE_DONE_ERROR);
+	}
+	callbacks = request->response.route->callbacks;
+	return(http_simple_GET_PUT_handler(request, callbacks->get,
+									   callbacks->put, callbacks->free));
+}
@@ -24,8 +24,8 @@
 #ifndef HTTP_HANDLER_H
 #define HTTP_HANDLER_H
 
-#include "tools/dl_list.h"
 #include "slighttp/http.h"
+#include "slighttp/http-latency.h"
 
 /**
  * @brief Return code when the handler is done.
@@ -57,13 +57,157 @@
  */
 #define RESPONSE_DONE_ERROR -3
 
-extern bool http_add_handler(char *uri, http_handler_callback handler);
-extern bool http_remove_handler(http_handler_callback handler);
+/**
+ * @brief Callbacks for each method of a route.
+ * 
+ * Used with #HTTP_METHOD_ROUTE. A NULL callback means that the
+ * method is not handled.
+ */
+struct http_method_handlers
+{
+	/**
+	 * @brief Create the response message of a GET or HEAD request.
+	 */
+	http_handler_callback get;
+	/**
+	 * @brief Handle a PUT request.
+	 */
+	http_handler_callback put;
+	/**
+	 * @brief Free data, when the response is done.
+	 */
+	http_handler_callback free;
+	/**
+	 * @brief Receive the message body in chunks as it arrives.
+	 * 
+	 * If NULL, the body is collected in `request->message`.
+	 */
+	http_body_callback body;
+};
+
+/**
+ * @brief Route used in normal mode.
+ */
+#define HTTP_ROUTES_NORMAL 0x01
+/**
+ * @brief Route used in network configuration mode.
+ */
+#define HTTP_ROUTES_CONFIG 0x02
+/**
+ * @brief Route used in all modes.
+ */
+#define HTTP_ROUTES_ALL 0xff
+
+/**
+ * @brief A route from an URI to a handler.
+ * 
+ * Routes are defined with #HTTP_ROUTE and #HTTP_METHOD_ROUTE, and are
+ * put in a table in flash by the linker. Flash can only be read 32 bits
+ * at a time, so every member is 32 bits.
+ */
+struct http_route
+{
+	/**
+	 * @brief The URI the route was defined with.
+	 */
+	const char *uri;
+	/**
+	 * @brief Length of the URI, without a trailing `*`.
+	 */
+	uint32 size;
+	/**
+	 * @brief True if the URI ends with `*`, matching everything below it.
+	 */
+	uint32 prefix;
+	/**
+	 * @brief Mask of the methods handled, see #HTTP_METHOD.
+	 */
+	uint32 methods;
+	/**
+	 * @brief Mask of the modes the route is used in.
+	 */
+	uint32 modes;
+	/**
+	 * @brief Handler callback.
+	 */
+	http_handler_callback handler;
+	/**
+	 * @brief Per method callbacks used by #http_method_handler.
+	 */
+	const struct http_method_handlers *callbacks;
+	/**
+	 * @brief Order the route was defined with.
+	 * 
+	 * #HTTP_ROUTE_DEFINE puts a 1 in front of it, so that a leading zero
+	 * does not make it octal.
+	 */
+	uint32 order;
+	/**
+	 * @brief Latency statistics, created when first needed.
+	 */
+	struct http_latency **latency;
+};
+
+/**
+ * @brief True if a route URI ends with `*`.
+ */
+#define HTTP_ROUTE_PREFIX(uri) ((uri)[sizeof(uri) - 2] == '*')
+
+/**
+ * @brief Define a route.
+ * 
+ * The route is put in its own section, and the linker sorts the
+ * sections by name into the route table. When looking for a handler,
+ * the first route in the table that matches the URI, the method, and
+ * the selected modes is used.
+ * 
+ * @param order Position in the table, must be unique and three digits.
+ * @param modes Mask of modes, see #HTTP_ROUTES_NORMAL.
+ * @param uri String literal with the URI of the route. If it ends with
+ *            `*`, everything below the URI is handled, except when a
+ *            route before this one handles it.
+ * @param methods Mask of methods, see #HTTP_METHOD. Requests for an URI
+ *                with a route, but none for the method, get status 405.
+ * @param handler Pointer to the callback.
+ * @param callbacks Per method callbacks, or NULL.
+ */
+#define HTTP_ROUTE_DEFINE(order, modes, uri, methods, handler, callbacks) \
+	static struct http_latency *http_route_latency_##order = NULL; \
+	static const struct http_route http_route_##order \
+	__attribute__((used, aligned(4), section(".irom0.http_routes." #order))) = \
+	{ uri, sizeof(uri) - 1 - HTTP_ROUTE_PREFIX(uri), HTTP_ROUTE_PREFIX(uri), \
+	  methods, modes, handler, callbacks, 1##order - 1000, \
+	  &http_route_latency_##order }
+
+/**
+ * @brief Define a route to a handler.
+ * 
+ * See #HTTP_ROUTE_DEFINE.
+ */
+#define HTTP_ROUTE(order, modes, uri, methods, handler) \
+	HTTP_ROUTE_DEFINE(order, modes, uri, methods, handler, NULL)
+
+/**
+ * @brief Define a route with per method callbacks.
+ * 
+ * The route is handled by #http_method_handler, GET and HEAD requests
+ * are accepted if there is a `get` callback, PUT if there is a `put`
+ * callback. See #HTTP_ROUTE_DEFINE.
+ */
+#define HTTP_METHOD_ROUTE(order, modes, uri, callbacks) \
+	HTTP_ROUTE_DEFINE(order, modes, uri, 0, http_method_handler, callbacks)
+
+extern void http_routes_select(uint32 modes);
 extern http_handler_callback http_get_handler(
 	struct http_request *request,
-	http_handler_callback start_handler
+	const struct http_route *start
 );
+extern http_body_callback http_get_body_callback(
+	struct http_request *request);
+extern struct http_latency *http_route_latency(
+	const struct http_route *route);
 extern signed int http_status_handler(struct http_request *request);
+extern signed int http_method_handler(struct http_request *request);
 extern signed int http_simple_GET_PUT_handler(
 	struct http_request *request, 
 	http_handler_callback get_cb,
@@ -0,0 +1,196 @@
+/** @file http-latency.c
+ *
+ * @brief Per route request latency histograms.
+ *
+ * Each phase of a request is timestamped using system_get_time(), and
+ * the time between phases is counted in fixed buckets, when the
+ * response is done. Statistics for a route are allocated the first
+ * time a response from it is done.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "http.h"
+#include "http-handler.h"
+#include "http-latency.h"
+
+/**
+ * @brief Upper bound in µs of each histogram bucket, the last bucket has none.
+ */
+const uint32 http_latency_bounds[HTTP_LATENCY_BUCKETS - 1] =
+{
+	250, 1000, 4000, 16000, 64000, 256000, 1000000
+};
+
+/**
+ * @brief Names of the intervals.
+ */
+const char *http_latency_interval_names[HTTP_LATENCY_INTERVALS] =
+{
+	"wait", "parse", "route", "queue", "send", "close", "total"
+};
+
+/**
+ * @brief Statistics of all routes that have been used.
+ */
+struct http_latency *http_latency_routes = NULL;
+
+/**
+ * @brief Create statistics for a route.
+ * 
+ * @param uri URI of the route.
+ * @param order Order of the route.
+ * @return The new statistics.
+ */
+struct http_latency *http_latency_new(const char *uri, unsigned short order)
+{
+	struct http_latency *latency;
+	struct http_latency **last = &http_latency_routes;
+	size_t uri_size = os_strlen(uri) + 1;
+	
+	debug("Latency statistics for %s.\n", uri);
+	latency = db_zalloc(sizeof(struct http_latency) + uri_size,
+						"latency http_latency_new");
+	if (!latency)
+	{
+		error("Could not allocate memory for latency statistics.\n");
+		return(NULL);
+	}
+	latency->uri = (char *)(latency + 1);
+	os_memcpy(latency->uri, uri, uri_size);
+	latency->order = order;
+	//Keep them in order of first use.
+	while (*last)
+	{
+		last = &(*last)->next;
+	}
+	*last = latency;
+	return(latency);
+}
+
+/**
+ * @brief Count an interval in a histogram.
+ * 
+ * @param latency The statistics of the route.
+ * @param interval The interval, see #http_latency_intervals.
+ * @param start Start time.
+ * @param end End time.
+ */
+static void add_time(struct http_latency *latency, unsigned char interval,
+					 uint32 start, uint32 end)
+{
+	uint32 time = end - start;
+	unsigned char bucket = 0;
+	
+	while ((bucket < HTTP_LATENCY_BUCKETS - 1) &&
+		   (time >= http_latency_bounds[bucket]))
+	{
+		bucket++;
+	}
+	if (latency->histogram[interval][bucket] < 0xFFFF)
+	{
+		latency->histogram[interval][bucket]++;
+	}
+}
+
+/**
+ * @brief Count the time until a sent callback.
+ * 
+ * @param request The request.
+ */
+void http_latency_sent(struct http_request *request)
+{
+	struct http_latency *latency = NULL;
+	uint32 *time = request->phase_time;
+	uint32 prev;
+	uint32 now = system_get_time();
+	
+	prev = time[HTTP_PHASE_SENT] ? time[HTTP_PHASE_SENT] : time[HTTP_PHASE_QUEUED];
+	if (request->response.route)
+	{
+		latency = http_route_latency(request->response.route);
+	}
+	if ((latency) && (prev))
+	{
+		add_time(latency, HTTP_LATENCY_SEND, prev, now);
+	}
+	time[HTTP_PHASE_SENT] = now;
+}
+
+/**
+ * @brief Count the intervals of a request that is done.
+ * 
+ * Phases that never happened are skipped.
+ * 
+ * @param request The request.
+ */
+void http_latency_done(struct http_request *request)
+{
+	struct http_latency *latency;
+	uint32 *time = request->phase_time;
+	uint32 last;
+	
+	http_latency_mark(request, HTTP_PHASE_CLOSE);
+	if (!request->response.route)
+	{
+		return;
+	}
+	latency = http_route_latency(request->response.route);
+	if (!latency)
+	{
+		return;
+	}
+	latency->count++;
+	if (time[HTTP_PHASE_RECV])
+	{
+		add_time(latency, HTTP_LATENCY_WAIT, time[HTTP_PHASE_CONNECT],
+				 time[HTTP_PHASE_RECV]);
+	}
+	if (time[HTTP_PHASE_PARSED])
+	{
+		add_time(latency, HTTP_LATENCY_PARSE, time[HTTP_PHASE_RECV],
+				 time[HTTP_PHASE_PARSED]);
+	}
+	if (time[HTTP_PHASE_ROUTED])
+	{
+		add_time(latency, HTTP_LATENCY_ROUTE, time[HTTP_PHASE_PARSED],
+				 time[HTTP_PHASE_ROUTED]);
+	}
+	last = time[HTTP_PHASE_ROUTED];
+	if (time[HTTP_PHASE_QUEUED])
+	{
+		add_time(latency, HTTP_LATENCY_QUEUE, time[HTTP_PHASE_ROUTED],
+				 time[HTTP_PHASE_QUEUED]);
+		last = time[HTTP_PHASE_QUEUED];
+	}
+	if (time[HTTP_PHASE_SENT])
+	{
+		last = time[HTTP_PHASE_SENT];
+	}
+	if (last)
+	{
+		add_time(latency, HTTP_LATENCY_CLOSE, last, time[HTTP_PHASE_CLOSE]);
+	}
+	add_time(latency, HTTP_LATENCY_TOTAL, time[HTTP_PHASE_CONNECT],
+			 time[HTTP_PHASE_CLOSE]);
+}
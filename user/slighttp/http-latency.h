@@ -0,0 +1,119 @@
+/** @file http-latency.h
+ *
+ * @brief Per route request latency histograms.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */ 
+#ifndef HTTP_LATENCY_H
+#define HTTP_LATENCY_H
+
+#include "c_types.h"
+#include "user_interface.h"
+#include "http.h"
+
+/**
+ * @brief Number of buckets in a histogram.
+ */
+#define HTTP_LATENCY_BUCKETS 8
+
+/**
+ * @brief Time intervals that are measured.
+ */
+enum http_latency_intervals
+{
+	/**
+	 * @brief From connection to first data received.
+	 */
+	HTTP_LATENCY_WAIT,
+	/**
+	 * @brief Parsing the request.
+	 */
+	HTTP_LATENCY_PARSE,
+	/**
+	 * @brief Finding the first handler.
+	 */
+	HTTP_LATENCY_ROUTE,
+	/**
+	 * @brief From handler selected to first data queued, includes
+	 *        waiting for the scheduler.
+	 */
+	HTTP_LATENCY_QUEUE,
+	/**
+	 * @brief From data queued, or the previous sent callback, to each
+	 *        sent callback.
+	 */
+	HTTP_LATENCY_SEND,
+	/**
+	 * @brief From the last sent callback to the response is done.
+	 */
+	HTTP_LATENCY_CLOSE,
+	/**
+	 * @brief From connection to the response is done.
+	 */
+	HTTP_LATENCY_TOTAL,
+	/**
+	 * @brief Number of intervals.
+	 */
+	HTTP_LATENCY_INTERVALS
+};
+
+/**
+ * @brief Latency statistics of a route.
+ */
+struct http_latency
+{
+	/**
+	 * @brief URI of the route.
+	 */
+	char *uri;
+	/**
+	 * @brief Order of the route, the URI is not unique.
+	 */
+	unsigned short order;
+	/**
+	 * @brief Number of responses done.
+	 */
+	unsigned long count;
+	/**
+	 * @brief Histogram of each interval, counts stop at 65535.
+	 */
+	unsigned short histogram[HTTP_LATENCY_INTERVALS][HTTP_LATENCY_BUCKETS];
+	/**
+	 * @brief Next route.
+	 */
+	struct http_latency *next;
+};
+
+/**
+ * @brief Timestamp a phase of a request.
+ */
+#define http_latency_mark(request, phase) \
+	((request)->phase_time[(phase)] = system_get_time())
+
+extern const uint32 http_latency_bounds[HTTP_LATENCY_BUCKETS - 1];
+extern const char *http_latency_interval_names[HTTP_LATENCY_INTERVALS];
+extern struct http_latency *http_latency_routes;
+
+extern struct http_latency *http_latency_new(const char *uri,
+											 unsigned short order);
+extern void http_latency_sent(struct http_request *request);
+extern void http_latency_done(struct http_request *request);
+
+#endif //HTTP_LATENCY_H
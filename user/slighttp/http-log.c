@@ -0,0 +1,232 @@
+/** @file http-log.c
+ *
+ * @brief Buffered access log.
+ *
+ * Access log records are kept in binary form in a ring buffer, and
+ * formatted and printed by a task, outside of the response handling.
+ * The records that have been printed stay around for the REST
+ * interface, until they are overwritten. If all records are waiting
+ * to be printed, new records are dropped and counted.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "ip_addr.h"
+#include "user_config.h"
+#include "task.h"
+#include "tools/ring.h"
+#include "net/tcp.h"
+#include "http.h"
+#include "http-common.h"
+#include "http-log.h"
+
+/**
+ * @brief Number of records dropped because the buffer was full.
+ */
+unsigned long http_log_dropped = 0;
+
+/**
+ * @brief Storage for the records.
+ */
+static struct http_log_record log_records[HTTP_LOG_RECORDS];
+
+/**
+ * @brief Ring buffer of records, oldest first.
+ */
+static struct ring_buffer log_ring;
+
+/**
+ * @brief Number of records at the end of the buffer not yet printed.
+ */
+static unsigned short n_unprinted = 0;
+
+/**
+ * @brief Dropped records that have been reported.
+ */
+static unsigned long dropped_printed = 0;
+
+/**
+ * @brief True while the print task is queued.
+ */
+static bool draining = false;
+
+/**
+ * @brief Signal of the print task.
+ */
+static os_signal_t log_signal;
+
+/**
+ * @brief Copy a string into a record field, truncating it if needed.
+ * 
+ * @param dest The field.
+ * @param src The string, or NULL.
+ * @param size Size of the field.
+ */
+static void copy_field(char *dest, const char *src, size_t size)
+{
+	size_t length;
+	
+	if (!src)
+	{
+		src = "-";
+	}
+	length = os_strlen(src);
+	if (length >= size)
+	{
+		length = size - 1;
+	}
+	os_memcpy(dest, src, length);
+	dest[length] = '\0';
+}
+
+/**
+ * @brief Print waiting records.
+ * 
+ * Prints a few records, and queues it self again if there are more.
+ * 
+ * @param parameter Not used.
+ */
+static void drain(os_param_t parameter)
+{
+	char line[HTTP_LOG_LINE_SIZE];
+	unsigned char n = 0;
+	
+	while ((n_unprinted) && (n < HTTP_LOG_DRAIN_BATCH))
+	{
+		http_log_format(ring_count(&log_ring) - n_unprinted, line);
+		db_printf("%s\n", line);
+		n_unprinted--;
+		n++;
+	}
+	if (http_log_dropped != dropped_printed)
+	{
+		db_printf("%lu access log records dropped.\n",
+				  http_log_dropped - dropped_printed);
+		dropped_printed = http_log_dropped;
+	}
+	if (n_unprinted)
+	{
+		task_raise_signal(log_signal, 0);
+	}
+	else
+	{
+		draining = false;
+	}
+}
+
+/**
+ * @brief Initialise the access log.
+ */
+void http_log_init(void)
+{
+	debug("Initialising access log.\n");
+	init_ring(&log_ring, log_records, sizeof(struct http_log_record),
+			  HTTP_LOG_RECORDS);
+	log_signal = task_add(drain);
+}
+
+/**
+ * @brief Add a record of a request that is done.
+ * 
+ * Nothing is printed here, it is left to a task.
+ * 
+ * @param request The request.
+ */
+void http_log_request(struct http_request *request)
+{
+	struct http_log_record *record;
+	
+	if (ring_full(&log_ring))
+	{
+		if (n_unprinted == ring_count(&log_ring))
+		{
+			http_log_dropped++;
+			return;
+		}
+		//Forget the oldest printed record.
+		ring_drop_front(&log_ring);
+	}
+	record = ring_back(&log_ring);
+	record->duration = system_get_time() -
+					   request->phase_time[HTTP_PHASE_CONNECT];
+	record->size = request->response.message_size;
+	record->status_code = request->response.status_code;
+	os_memcpy(record->ip, request->connection->remote_ip, sizeof(record->ip));
+	record->type = request->type;
+	copy_field(record->version, request->version, sizeof(record->version));
+	copy_field(record->uri, request->uri, sizeof(record->uri));
+	ring_commit_back(&log_ring);
+	n_unprinted++;
+	
+	if (!draining)
+	{
+		draining = true;
+		task_raise_signal(log_signal, 0);
+	}
+}
+
+/**
+ * @brief Number of records in the log.
+ * 
+ * @return The number of records.
+ */
+unsigned short http_log_count(void)
+{
+	return(ring_count(&log_ring));
+}
+
+/**
+ * @brief Format a record as a Common Log Format line.
+ * 
+ *  host ident authuser date request status bytes
+ * 
+ * The date is unknown, and the time it took to respond is added in µs:
+ * 
+ *  192.168.4.2 - - - "GET /index.html HTTP/1.1" 200 2326 10345
+ * 
+ * See [CLF](https://en.wikipedia.org/wiki/Common_Log_Format).
+ * 
+ * @param n Number of the record, 0 is the oldest.
+ * @param line Where to put the line, at least #HTTP_LOG_LINE_SIZE bytes.
+ * @return Length of the line, 0 if there is no such record.
+ */
+size_t http_log_format(unsigned short n, char *line)
+{
+	struct http_log_record *record;
+	const char *method = http_method_names[HTTP_NONE];
+	
+	record = ring_peek(&log_ring, n);
+	if (!record)
+	{
+		line[0] = '\0';
+		return(0);
+	}
+	if (record->type <= HTTP_CONNECT)
+	{
+		method = http_method_names[record->type];
+	}
+	return(os_sprintf(line, IPSTR " - - - \"%s %s HTTP/%s\" %d %lu %lu",
+					  IP2STR(record->ip), method, record->uri,
+					  record->version, record->status_code,
+					  (unsigned long)record->size,
+					  (unsigned long)record->duration));
+}
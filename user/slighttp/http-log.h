@@ -0,0 +1,98 @@
+/** @file http-log.h
+ *
+ * @brief Buffered access log.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */ 
+#ifndef HTTP_LOG_H
+#define HTTP_LOG_H
+
+#include "c_types.h"
+#include "http.h"
+
+#ifndef HTTP_LOG_RECORDS
+/**
+ * @brief Number of access log records kept, must be a power of two.
+ */
+#define HTTP_LOG_RECORDS 16
+#endif
+
+#ifndef HTTP_LOG_URI_SIZE
+/**
+ * @brief Room for the URI in a record, longer URIs are truncated.
+ */
+#define HTTP_LOG_URI_SIZE 40
+#endif
+
+#ifndef HTTP_LOG_DRAIN_BATCH
+/**
+ * @brief Records printed each time the log task runs.
+ */
+#define HTTP_LOG_DRAIN_BATCH 2
+#endif
+
+/**
+ * @brief Maximum length of a formatted log line.
+ */
+#define HTTP_LOG_LINE_SIZE (HTTP_LOG_URI_SIZE + 72)
+
+/**
+ * @brief An access log record.
+ */
+struct http_log_record
+{
+	/**
+	 * @brief Time from connection to the response was done in µs.
+	 */
+	uint32 duration;
+	/**
+	 * @brief Size of the message sent.
+	 */
+	uint32 size;
+	/**
+	 * @brief Status code.
+	 */
+	uint16 status_code;
+	/**
+	 * @brief Remote IP address.
+	 */
+	uint8 ip[4];
+	/**
+	 * @brief Request method, see #request_types.
+	 */
+	uint8 type;
+	/**
+	 * @brief HTTP version, like "1.1".
+	 */
+	char version[4];
+	/**
+	 * @brief Zero terminated URI.
+	 */
+	char uri[HTTP_LOG_URI_SIZE];
+};
+
+extern unsigned long http_log_dropped;
+
+extern void http_log_init(void);
+extern void http_log_request(struct http_request *request);
+extern unsigned short http_log_count(void);
+extern size_t http_log_format(unsigned short n, char *line);
+
+#endif //HTTP_LOG_H
@@ -21,27 +21,115 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  * MA 02110-1301, USA.
  */ 
+#include "c_types.h"
+#include "user_config.h"
 #include "osapi.h"
 #include "http-mime.h"
 
+/**
+ * @brief MIME-type table entry, the length is found at compile time.
+ */
+#define HTTP_MIME_ENTRY(EXT, TYPE) { EXT, TYPE, sizeof(TYPE) - 1 }
+
 /**
  * @brief Mapping file extensions to MIME-types.
  */
 struct http_mime_type http_mime_types[HTTP_N_MIME_TYPES] =
 {
-	{"htm", "text/htm"}, //MIME_HTM
-	{"html", "text/html"}, //MIME_HTML
-	{"css", "text/css"}, //MIME_CSS
-	{"js", "text/javascript"}, //MIME_JS
-	{"json", "application/json"}, //MIME_JSON
-	{"txt", "text/plain"}, //MIME_TXT
-	{"jpg", "image/jpeg"}, //MIME_JPG
-	{"jpeg", "image/jpeg"}, //MIME_JPEG
-	{"png", "image/png"}, //MIME_PNG
-	{"ico", "image/x-icon"}, //MIME_ICO
-	{"gz", "application/x-gzip"} //MIME_GZIP 
+	HTTP_MIME_ENTRY("htm", "text/html"), //MIME_HTM
+	HTTP_MIME_ENTRY("html", "text/html"), //MIME_HTML
+	HTTP_MIME_ENTRY("css", "text/css"), //MIME_CSS
+	HTTP_MIME_ENTRY("js", "text/javascript"), //MIME_JS
+	HTTP_MIME_ENTRY("json", "application/json"), //MIME_JSON
+	HTTP_MIME_ENTRY("txt", "text/plain"), //MIME_TXT
+	HTTP_MIME_ENTRY("jpg", "image/jpeg"), //MIME_JPG
+	HTTP_MIME_ENTRY("jpeg", "image/jpeg"), //MIME_JPEG
+	HTTP_MIME_ENTRY("png", "image/png"), //MIME_PNG
+	HTTP_MIME_ENTRY("ico", "image/x-icon"), //MIME_ICO
+	HTTP_MIME_ENTRY("gz", "application/x-gzip"), //MIME_GZIP
+	HTTP_MIME_ENTRY("svg", "image/svg+xml"), //MIME_SVG
+	HTTP_MIME_ENTRY("woff2", "font/woff2"), //MIME_WOFF2
+	HTTP_MIME_ENTRY("wasm", "application/wasm"), //MIME_WASM
+	HTTP_MIME_ENTRY("map", "application/json"), //MIME_MAP
+	HTTP_MIME_ENTRY("bin", "application/octet-stream") //MIME_BIN
 };
 
+/**
+ * @brief Pack up to four extension characters into a switch key.
+ */
+#define HTTP_MIME_KEY(A, B, C, D) \
+	(((uint32)(A) << 24) | ((uint32)(B) << 16) | ((uint32)(C) << 8) | (uint32)(D))
+
+/**
+ * @brief Find the MIME-type of a file extension.
+ * 
+ * The first four characters are packed in to an integer, and matched
+ * by a switch, so no string compares are done. Lower and upper case
+ * are treated the same.
+ * 
+ * @param ext The extension, without the dot.
+ * @return Index in #http_mime_types, #MIME_BIN if the extension is
+ *         unknown.
+ */
+unsigned char http_mime_lookup(const char *ext)
+{
+	uint32 key = 0;
+	unsigned char length = 0;
+	
+	if (!ext)
+	{
+		return(MIME_BIN);
+	}
+	//Extensions are left aligned, setting bit 5 lower cases letters.
+	while ((ext[length] != '\0') && (length < 4))
+	{
+		key |= (uint32)(ext[length] | 0x20) << (24 - (length << 3));
+		length++;
+	}
+	if (ext[length] != '\0')
+	{
+		//Only woff2 is longer than four characters.
+		if ((key == HTTP_MIME_KEY('w', 'o', 'f', 'f')) &&
+			(ext[4] == '2') && (ext[5] == '\0'))
+		{
+			return(MIME_WOFF2);
+		}
+		return(MIME_BIN);
+	}
+	switch (key)
+	{
+		case HTTP_MIME_KEY('h', 't', 'm', 0):
+			return(MIME_HTM);
+		case HTTP_MIME_KEY('h', 't', 'm', 'l'):
+			return(MIME_HTML);
+		case HTTP_MIME_KEY('c', 's', 's', 0):
+			return(MIME_CSS);
+		case HTTP_MIME_KEY('j', 's', 0, 0):
+			return(MIME_JS);
+		case HTTP_MIME_KEY('j', 's', 'o', 'n'):
+			return(MIME_JSON);
+		case HTTP_MIME_KEY('t', 'x', 't', 0):
+			return(MIME_TXT);
+		case HTTP_MIME_KEY('j', 'p', 'g', 0):
+			return(MIME_JPG);
+		case HTTP_MIME_KEY('j', 'p', 'e', 'g'):
+			return(MIME_JPEG);
+		case HTTP_MIME_KEY('p', 'n', 'g', 0):
+			return(MIME_PNG);
+		case HTTP_MIME_KEY('i', 'c', 'o', 0):
+			return(MIME_ICO);
+		case HTTP_MIME_KEY('g', 'z', 0, 0):
+			return(MIME_GZIP);
+		case HTTP_MIME_KEY('s', 'v', 'g', 0):
+			return(MIME_SVG);
+		case HTTP_MIME_KEY('w', 'a', 's', 'm'):
+			return(MIME_WASM);
+		case HTTP_MIME_KEY('m', 'a', 'p', 0):
+			return(MIME_MAP);
+	}
+	return(MIME_BIN);
+}
+
 /**
  * @brief Get extension of a file.
  * 
@@ -29,10 +29,26 @@
  */
 struct http_mime_type
 {
+	/**
+	 * @brief File extension.
+	 */
 	char *ext;
+	/**
+	 * @brief MIME-type.
+	 */
 	char *type;
+	/**
+	 * @brief Length of the MIME-type.
+	 */
+	unsigned char type_size;
 };
 
+/**
+ * @brief Index of each MIME-type in #http_mime_types.
+ * 
+ * The index is stored in DBFFS file headers, only add new types at the
+ * end, and keep tools/dbffs-tools/src/dbffs-mime.h in sync.
+ */
 enum http_mime_enum
 {
 	MIME_HTM,
@@ -46,11 +62,17 @@ enum http_mime_enum
 	MIME_PNG,
 	MIME_ICO,
 	MIME_GZIP,
+	MIME_SVG,
+	MIME_WOFF2,
+	MIME_WASM,
+	MIME_MAP,
+	MIME_BIN,
 	HTTP_N_MIME_TYPES
 };
 
 extern struct http_mime_type http_mime_types[HTTP_N_MIME_TYPES];
 
 extern char *http_mime_get_ext(char *filename);
+extern unsigned char http_mime_lookup(const char *ext);
 
-#endif //HTTP_TCP_H
+#endif //HTTP_MIME_H
@@ -141,20 +141,60 @@ static size_t http_get_headers_size(
 }
 
 /**
- * @brief Parse the request-line, header fields, and save message.
+ * @brief Parse the value of a `Content-Length` header.
+ * 
+ * Only digits are allowed, and the value must fit a `size_t`.
+ * 
+ * @param value The value.
+ * @param size Size of the value.
+ * @param length Set to the length.
+ * @return True on success, false if the value is not a valid length.
+ */
+static bool parse_content_length(const char *value, size_t size, size_t *length)
+{
+	size_t digit;
+	size_t i;
+	
+	if (!size)
+	{
+		return(false);
+	}
+	*length = 0;
+	for (i = 0; i < size; i++)
+	{
+		if ((value[i] < '0') || (value[i] > '9'))
+		{
+			return(false);
+		}
+		digit = value[i] - '0';
+		if (*length > (((size_t)-1) - digit) / 10)
+		{
+			return(false);
+		}
+		*length = *length * 10 + digit;
+	}
+	return(true);
+}
+
+/**
+ * @brief Parse the request-line and header fields.
  * 
  * Parse the request-line and header fields of a HTTP request. Put the whole thing
- * in a #http_request and add it to the #tcp_connection data. Any additional
- * data ends up in request.message.
+ * in a #http_request and add it to the #tcp_connection data. The size of
+ * the message body is taken from the `Content-Length` header, or is the
+ * rest of the received data if there is none. The body itself is passed
+ * to #http_request_body.
  * 
  * @param connection Pointer to the connection data.
- * @return `true`on success.
+ * @param length Size of the received data.
+ * @return Size of the request-line and header fields, or 0 on errors.
  */
-bool http_parse_request(struct tcp_connection *connection, unsigned short length)
+size_t http_parse_request(struct tcp_connection *connection, unsigned short length)
 {
     struct http_request *request = connection->user;
     char *request_entry, *next_entry;
-	size_t size;
+	char *value;
+	size_t size, value_size;
 	
 	debug("Parsing request line (%p):\n", connection->callback_data.data);
 	size = http_get_request_type(connection);
@@ -177,7 +217,13 @@ bool http_parse_request(struct tcp_connection *connection, unsigned short length
     
     //Get mem and save uri.
     size = next_entry - request_entry;
-    request->uri = db_malloc(size + 1, "request->uri http_parse_request");
+    request->uri = arena_alloc(&request->arena, size + 1);
+    if (!request->uri)
+    {
+        error("Could not allocate memory for the URI.\n");
+        request->response.status_code = 500;
+        return(false);
+    }
     os_strncpy(request->uri, request_entry, size);
     request->uri[size] = '\0';
     debug(" URI (%p): %s\n", request_entry, request->uri); 
@@ -202,7 +248,13 @@ bool http_parse_request(struct tcp_connection *connection, unsigned short length
     
     //Get mem and save version.
     size = next_entry - request_entry;
-    request->version = db_malloc(size + 1, "request->version http_parse_request");
+    request->version = arena_alloc(&request->arena, size + 1);
+    if (!request->version)
+    {
+        error("Could not allocate memory for the version.\n");
+        request->response.status_code = 500;
+        return(false);
+    }
     os_strncpy(request->version, request_entry, size);
     request->version[size] = '\0';
     debug(" Version (%p): %s\n", request_entry, request->version);
@@ -213,7 +265,13 @@ bool http_parse_request(struct tcp_connection *connection, unsigned short length
 	if (size > 0)
 	{
 		debug(" Copying %d bytes of header data.\n", size);
-		request->headers = db_malloc(size + 1, "request->headers http_parse_request");
+		request->headers = arena_alloc(&request->arena, size + 1);
+		if (!request->headers)
+		{
+			error("Could not allocate memory for the headers.\n");
+			request->response.status_code = 500;
+			return(false);
+		}
 		os_memcpy(request->headers, next_entry, size);
 		request->headers[size] = '\0';
 		//Forward.
@@ -225,56 +283,207 @@ bool http_parse_request(struct tcp_connection *connection, unsigned short length
 	}
 	
     //Get length of message data if any.
-    size = length - (next_entry - connection->callback_data.data);
-    debug(" Message length: %d.\n", size);
-    if (size)
+    size = next_entry - connection->callback_data.data;
+    value = http_get_header(request, "Content-Length", &value_size);
+    if (value)
     {
-
-		request->message = db_malloc(sizeof(char) * (size + 1), "request->message http_parse_request");
-		memcpy(request->message, next_entry, size);
-		request->message[size] = '\0';
-		debug("%s\n", request->message);
+		if (!parse_content_length(value, value_size, &request->content_length))
+		{
+			error("Invalid Content-Length: %.*s.\n", value_size, value);
+			request->content_length = 0;
+			request->response.status_code = 400;
+			return(false);
+		}
 	}
+	else
+	{
+		request->content_length = length - size;
+	}
+    debug(" Message length: %d.\n", request->content_length);
 
     debug(" Done parsing request.\n");
-    return(true);
+    return(size);
 }
 
 /**
- * @brief Free data allocated by a request.
+ * @brief Find a header field of a request.
  * 
- * @param request Pointer to the request to free.
+ * The name is matched without regard to case.
+ * 
+ * @param request The request.
+ * @param name Name of the header, without the colon.
+ * @param size Set to the size of the value.
+ * @return Pointer to the value in the headers, or NULL if not found.
  */
-void http_free_request(struct http_request *request)
+char *http_get_header(struct http_request *request, const char *name,
+					  size_t *size)
 {
-	debug("Freeing request data at %p.\n", request);
-	if (request)
+	char *line = request->headers;
+	char *value;
+	size_t name_size;
+	size_t i;
+	
+	if (!line)
 	{
-		if (request->response.message)
+		return(NULL);
+	}
+	name_size = os_strlen(name);
+	while (*line)
+	{
+		//Compare the name, header names only have letters, digits, and '-'.
+		for (i = 0; i < name_size; i++)
 		{
-			debug("Deallocating response message.\n");
-			db_free(request->response.message);
+			if ((line[i] | 0x20) != (name[i] | 0x20))
+			{
+				break;
+			}
+		}
+		if ((i == name_size) && (line[i] == ':'))
+		{
+			value = line + i + 1;
+			HTTP_SKIP_SPACES(value);
+			*size = 0;
+			while ((value[*size]) && (value[*size] != '\r') &&
+				   (value[*size] != '\n'))
+			{
+				(*size)++;
+			}
+			//Trailing spaces are not part of the value.
+			while ((*size) && (value[*size - 1] == ' '))
+			{
+				(*size)--;
+			}
+			debug("Header %s: %.*s.\n", name, *size, value);
+			return(value);
+		}
+		//Next line.
+		line = strchrs(line, "\n");
+		if (!line)
+		{
+			break;
 		}
-		if (request->uri)
+		line++;
+	}
+	return(NULL);
+}
+
+/**
+ * @brief Handle received message body data.
+ * 
+ * If the route has a body callback, the data is passed to it as it
+ * arrives. Otherwise the body is collected in `request->message`, if it
+ * is no larger than #HTTP_BODY_MAX. A larger body is answered with 413
+ * right away, and the rest of it is not read. Data after other errors is
+ * discarded.
+ * 
+ * @param request The request.
+ * @param data The data.
+ * @param size Size of the data.
+ * @return True when the whole body has been received.
+ */
+bool http_request_body(struct http_request *request, char *data, size_t size)
+{
+	http_body_callback body_cb;
+	
+	//Pipelined requests are not supported.
+	if (size > (request->content_length - request->body_received))
+	{
+		size = request->content_length - request->body_received;
+	}
+	debug("Received %d bytes of body, %d of %d so far.\n", size,
+		  request->body_received, request->content_length);
+	body_cb = http_get_body_callback(request);
+	if ((!body_cb) && (request->content_length > HTTP_BODY_MAX) &&
+		(request->response.status_code < 400))
+	{
+		warn("Message body of %d bytes is too large.\n",
+			 request->content_length);
+		request->response.status_code = 413;
+		//Answer now, the connection is closed after the response.
+		http_request_hold(request);
+		return(true);
+	}
+	if ((!size) || (request->response.status_code >= 400))
+	{
+		//Nothing to do, or discarding.
+	}
+	else if (body_cb)
+	{
+		if (!body_cb(request, data, size))
 		{
-			debug("Deallocating request URI %s.\n", request->uri);
-			db_free(request->uri);
+			warn("Body callback failed.\n");
+			if (request->response.status_code < 400)
+			{
+				request->response.status_code = 500;
+			}
+			http_request_unhold(request);
 		}
-		if (request->version)
+	}
+	else
+	{
+		if (!request->message)
+		{
+			request->message = arena_alloc(&request->arena,
+										   request->content_length + 1);
+		}
+		if (!request->message)
 		{
-			debug("Deallocating request version %s.\n", request->version);
-			db_free(request->version);
+			//The rest of the body is discarded, like a too large one.
+			error("Could not allocate memory for the message body.\n");
+			request->response.status_code = 500;
 		}
-		if (request->message)
+		else
 		{
-			debug("Deallocating request message.\n");
-			db_free(request->message);
+			os_memcpy(request->message + request->body_received, data, size);
+			request->message[request->body_received + size] = '\0';
 		}
-		if (request->headers)
+	}
+	request->body_received += size;
+	return(request->body_received >= request->content_length);
+}
+
+/**
+ * @brief Stop receiving data on the connection of a request.
+ * 
+ * Used by body callbacks, that can not keep up. The TCP window fills up,
+ * and the client waits.
+ * 
+ * @param request The request.
+ */
+void http_request_hold(struct http_request *request)
+{
+	debug("Holding body of request %p.\n", request);
+	tcp_hold(request->connection);
+}
+
+/**
+ * @brief Start receiving data on the connection of a request again.
+ * 
+ * @param request The request.
+ */
+void http_request_unhold(struct http_request *request)
+{
+	debug("Resuming body of request %p.\n", request);
+	tcp_unhold(request->connection);
+}
+
+/**
+ * @brief Free data allocated by a request.
+ * 
+ * @param request Pointer to the request to free.
+ */
+void http_free_request(struct http_request *request)
+{
+	debug("Freeing request data at %p.\n", request);
+	if (request)
+	{
+		if (request->response.message)
 		{
-			debug("Deallocating request headers.\n");
-			db_free(request->headers);
+			debug("Deallocating response message.\n");
+			db_free(request->response.message);
 		}
+		debug("Deallocating request arena.\n");
+		arena_free(&request->arena);
 		debug("Deallocating request.\n");
 		db_free(request);
 	}
@@ -27,7 +27,13 @@
 
 #include "http.h"
 
-extern bool http_parse_request(struct tcp_connection *connection, unsigned short length);
+extern size_t http_parse_request(struct tcp_connection *connection, unsigned short length);
+extern bool http_request_body(struct http_request *request, char *data,
+							  size_t size);
+extern void http_request_hold(struct http_request *request);
+extern void http_request_unhold(struct http_request *request);
 extern void http_free_request(struct http_request *request);
+extern char *http_get_header(struct http_request *request, const char *name,
+							 size_t *size);
 
 #endif //HTTP_REQUEST_H
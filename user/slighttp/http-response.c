@@ -27,6 +27,7 @@
 #include "user_config.h"
 #include "net/tcp.h"
 #include "fs/fs.h"
+#include "fs/int_flash.h"
 #include "tools/strxtra.h"
 #include "http-common.h"
 #include "http-mime.h"
@@ -35,6 +36,8 @@
 #include "http-response.h"
 #include "http-tcp.h"
 #include "http-handler.h"
+#include "http-latency.h"
+#include "http-log.h"
 
 /**
  * @brief Pointer to a pointer to the connection.
@@ -43,10 +46,183 @@
  */
  void *connection_ptr = NULL;
 
+/**
+ * @brief Number of bytes copied, referenced, and read by the send functions.
+ */
+struct http_send_stats http_send_counters;
+
+/**
+ * @brief Send buffers shared by all responses.
+ */
+static char send_buffers[HTTP_SEND_BUFFERS][HTTP_SEND_BUFFER_SIZE];
+
+/**
+ * @brief Request using each send buffer, or NULL.
+ */
+static struct http_request *send_buffer_users[HTTP_SEND_BUFFERS];
+
+/**
+ * @brief Number of send buffers not in use.
+ */
+static unsigned char n_free_send_buffers = HTTP_SEND_BUFFERS;
+
+/**
+ * @brief Get a send buffer from the pool for a response.
+ * 
+ * @param request The request of the response.
+ * @return True if the response has a send buffer.
+ */
+bool http_acquire_send_buffer(struct http_request *request)
+{
+	unsigned char i;
+	
+	if (request->response.send_buffer)
+	{
+		return(true);
+	}
+	for (i = 0; i < HTTP_SEND_BUFFERS; i++)
+	{
+		if (!send_buffer_users[i])
+		{
+			debug("Send buffer %d to request %p.\n", i, request);
+			send_buffer_users[i] = request;
+			n_free_send_buffers--;
+			request->response.send_buffer = send_buffers[i];
+			request->response.send_buffer_pos = send_buffers[i];
+			request->response.n_segments = 0;
+			return(true);
+		}
+	}
+	debug("No free send buffers.\n");
+	return(false);
+}
+
+/**
+ * @brief Give the send buffer of a response back to the pool.
+ * 
+ * @param request The request of the response.
+ */
+void http_release_send_buffer(struct http_request *request)
+{
+	unsigned char i;
+	
+	if (!request->response.send_buffer)
+	{
+		return;
+	}
+	for (i = 0; i < HTTP_SEND_BUFFERS; i++)
+	{
+		if (send_buffer_users[i] == request)
+		{
+			debug("Send buffer %d released by request %p.\n", i, request);
+			send_buffer_users[i] = NULL;
+			n_free_send_buffers++;
+			break;
+		}
+	}
+	request->response.send_buffer = NULL;
+	request->response.send_buffer_pos = NULL;
+	request->response.n_segments = 0;
+}
+
+/**
+ * @brief Number of send buffers not in use.
+ * 
+ * @return Free buffers.
+ */
+unsigned char http_send_buffers_free(void)
+{
+	return(n_free_send_buffers);
+}
+
+/**
+ * @brief A precomputed status-line.
+ */
+struct http_status_line
+{
+	/**
+	 * @brief Status code.
+	 */
+	unsigned short code;
+	/**
+	 * @brief Length of the status-line.
+	 */
+	unsigned char size;
+	/**
+	 * @brief The status-line.
+	 */
+	const char *line;
+};
+
+/**
+ * @brief Status-line table entry, the length is found at compile time.
+ */
+#define HTTP_STATUS_ENTRY(CODE, LINE) { CODE, HTTP_CONST_SIZE(LINE), LINE }
+
+/**
+ * @brief The status-lines known by the server.
+ */
+static const struct http_status_line http_status_lines[] =
+{
+	HTTP_STATUS_ENTRY(101, HTTP_STATUS_101),
+	HTTP_STATUS_ENTRY(200, HTTP_STATUS_200),
+	HTTP_STATUS_ENTRY(204, HTTP_STATUS_204),
+	HTTP_STATUS_ENTRY(400, HTTP_STATUS_400),
+	HTTP_STATUS_ENTRY(403, HTTP_STATUS_403),
+	HTTP_STATUS_ENTRY(404, HTTP_STATUS_404),
+	HTTP_STATUS_ENTRY(405, HTTP_STATUS_405),
+	HTTP_STATUS_ENTRY(413, HTTP_STATUS_413),
+	HTTP_STATUS_ENTRY(500, HTTP_STATUS_500),
+	HTTP_STATUS_ENTRY(501, HTTP_STATUS_501),
+	HTTP_STATUS_ENTRY(503, HTTP_STATUS_503)
+};
+
+/**
+ * @brief Number of entries in #http_status_lines.
+ */
+#define HTTP_N_STATUS_LINES (sizeof(http_status_lines) / sizeof(struct http_status_line))
+
+/**
+ * @brief Reserve space at the end of the send buffer.
+ * 
+ * The caller writes the data directly into the returned space.
+ * 
+ * @param connection A pointer to the connection to use to send the data.
+ * @param size Size (in bytes) to reserve.
+ * @return Pointer to the reserved space, or NULL if there is no room.
+ */
+static char *reserve(struct tcp_connection *connection, size_t size)
+{
+	struct http_request *request;
+	size_t buffer_free;
+	char *ret;
+	
+	request = connection->user;
+	if (!request->response.send_buffer)
+	{
+		warn("No send buffer.\n");
+		return(NULL);
+	}
+	
+	buffer_free = HTTP_SEND_BUFFER_SIZE - (request->response.send_buffer_pos - request->response.send_buffer);
+	if (buffer_free < size)
+	{
+		debug(" Send buffer to small for %d bytes, currently %d bytes free.\n", size, buffer_free);
+		return(NULL);
+	}
+	ret = request->response.send_buffer_pos;
+	request->response.send_buffer_pos += size;
+	http_send_counters.copied += size;
+	debug(" Buffer free %d.\n", buffer_free - size);
+	
+	return(ret);
+}
+
 /**
  * @brief Send HTTP response status line.
  * 
- * Handles 200, 204, 400, 403, 405, and 501.
+ * Known status codes use a precomputed status-line, others get one
+ * without a reason phrase.
  * 
  * @param connection Pointer to the connection to use. 
  * @param code Status code to use in the status line.
@@ -54,64 +230,37 @@
  */
 unsigned char http_send_status_line(struct tcp_connection *connection, unsigned short status_code)
 {
-	size_t size;
-	char *response;
-	char status_line[15];
+	char *pos;
+	unsigned char i;
 
 	debug("Sending status line with status code %d.\n", status_code);	
-	switch (status_code)
+	for (i = 0; i < HTTP_N_STATUS_LINES; i++)
 	{
-		case 200:
-			response = HTTP_STATUS_200;
-			size = os_strlen(HTTP_STATUS_200);
-			break;
-		case 204: 
-			response = HTTP_STATUS_204;
-			size = os_strlen(HTTP_STATUS_204);
-			break;
-		case 400: 
-			response = HTTP_STATUS_400;
-			size = os_strlen(HTTP_STATUS_400);
-			break;
-		case 403: 
-			response = HTTP_STATUS_403;
-			size = os_strlen(HTTP_STATUS_403);
-			break;
-		case 404: 
-			response = HTTP_STATUS_404;
-			size = os_strlen(HTTP_STATUS_404);
-			break;
-		case 405: 
-			response = HTTP_STATUS_405;
-			size = os_strlen(HTTP_STATUS_405);
-			break;				  
-		case 500: 
-			response = HTTP_STATUS_500;
-			size = os_strlen(HTTP_STATUS_500);
-			break;
-		case 501: 
-			response = HTTP_STATUS_501;
-			size = os_strlen(HTTP_STATUS_501);
-			break;
-		default:  
-			debug(" Unknown response code: %d.\n", status_code);
-			os_memcpy(status_line, HTTP_STATUS_HTTP_VERSION " ", 9);
-			size = 9;
-			itoa(status_code, status_line + size, 10);
-			size += 3;
-			memcpy(status_line + size, "\r\n\0", 3);
-			size += 2;
-			response = status_line;
-			break;
+		if (http_status_lines[i].code == status_code)
+		{
+			return(http_send_ref(connection, http_status_lines[i].line,
+								 http_status_lines[i].size));
+		}
+	}
+	
+	debug(" Unknown response code: %d.\n", status_code);
+	pos = reserve(connection, HTTP_CONST_SIZE(HTTP_STATUS_HTTP_VERSION " 000 \r\n"));
+	if (!pos)
+	{
+		return(0);
 	}
-	return(http_send(connection, response, size));
+	os_memcpy(pos, HTTP_STATUS_HTTP_VERSION " ", HTTP_CONST_SIZE(HTTP_STATUS_HTTP_VERSION " "));
+	pos += HTTP_CONST_SIZE(HTTP_STATUS_HTTP_VERSION " ");
+	pos[0] = '0' + (status_code / 100) % 10;
+	pos[1] = '0' + (status_code / 10) % 10;
+	pos[2] = '0' + status_code % 10;
+	os_memcpy(pos + 3, " \r\n", 3);
+	return(HTTP_CONST_SIZE(HTTP_STATUS_HTTP_VERSION " 000 \r\n"));
 }
 
 /**
  * @brief Send a header.
  * 
- * @note Header name and value may be no larger than 508 bytes.
- * 
  * @param connection Pointer to the connection to use.
  * @param name The name of the header.
  * @param value The value of the header.
@@ -119,76 +268,89 @@ unsigned char http_send_status_line(struct tcp_connection *connection, unsigned
  */
 unsigned short http_send_header(struct tcp_connection *connection, char *name, char *value)
 {
-	char header[512];
-	size_t size;
+	size_t name_size, value_size;
+	char *pos;
 
 	debug("Sending header (%s: %s).\n", name, value);
-	size = os_sprintf(header, "%s: %s\r\n", name, value);
-	return(http_send(connection, header, size));
-
+	name_size = os_strlen(name);
+	value_size = os_strlen(value);
+	pos = reserve(connection, name_size + value_size + 4);
+	if (!pos)
+	{
+		return(0);
+	}
+	os_memcpy(pos, name, name_size);
+	pos += name_size;
+	*pos++ = ':';
+	*pos++ = ' ';
+	os_memcpy(pos, value, value_size);
+	pos += value_size;
+	*pos++ = '\r';
+	*pos = '\n';
+	return(name_size + value_size + 4);
 }
 
 /**
  * @brief Send web server default headers.
  * 
- * Send `Connection`, `Server`, `Content-Length`, and `Content-Type`.
+ * Send `Connection`, `Server`, `Content-Length`, `Content-Type`, and
+ * the empty line that ends the headers.
  * 
  * @param request The request to respond to.
  * @param size Message size.
- * @param mime Mime type file extension.
+ * @param mime Index of the MIME-type in #http_mime_types.
  * @return Size of send data.
  */
 signed int http_send_default_headers(
 	struct http_request *request,
 	size_t size,
-	char *mime
+	unsigned char mime
 )
 {
-	char str_size[16];
-	unsigned int i;
+	char str_size[11];
+	size_t size_size, header_size;
+	char *pos;
 	signed int ret;
 	
+	if (mime >= HTTP_N_MIME_TYPES)
+	{
+		debug(" Unknown MIME type %d, using application/octet-stream.\n", mime);
+		mime = MIME_BIN;
+	}
 	//Always send connections close and server info.
-	ret = http_send_header(request->connection, "Connection",
-						   "close");
-	ret += http_send_header(request->connection, "Server",
-							HTTP_SERVER_NAME);
-	os_sprintf(str_size, "%d", size);
-	//Send message length.
-	ret += http_send_header(request->connection, 
-							"Content-Length",
-							str_size);
-	//Find the MIME-type
-	if (mime)
+	ret = http_send_ref(request->connection, HTTP_HEADERS_FIXED,
+						HTTP_CONST_SIZE(HTTP_HEADERS_FIXED));
+	size_size = utoa(size, str_size);
+	
+	//Send message length, type, and end of headers in one go.
+	header_size = HTTP_CONST_SIZE(HTTP_HEADER_CONTENT_LENGTH) + size_size +
+				  HTTP_CONST_SIZE(HTTP_HEADER_CONTENT_TYPE) +
+				  http_mime_types[mime].type_size +
+				  HTTP_CONST_SIZE(HTTP_HEADERS_END);
+	pos = reserve(request->connection, header_size);
+	if (!pos)
 	{
-		for (i = 0; i < HTTP_N_MIME_TYPES; i++)
-		{
-			//TODO: Maybe use os_strcmp to avoid mixing up htm and html.
-			if (os_strcmp(http_mime_types[i].ext, mime) == 0)
-			{
-				break;
-			}
-		}
-		if ((i >= HTTP_N_MIME_TYPES) || (!mime))
-		{
-			debug(" Did not find a usable MIME type, using application/octet-stream.\n");
-			ret += http_send_header(request->connection, "Content-Type", "application/octet-stream");
-		}
-		else
-		{
-			ret += http_send_header(request->connection, "Content-Type", http_mime_types[i].type);
-		}
+		return(ret);
 	}
+	os_memcpy(pos, HTTP_HEADER_CONTENT_LENGTH, HTTP_CONST_SIZE(HTTP_HEADER_CONTENT_LENGTH));
+	pos += HTTP_CONST_SIZE(HTTP_HEADER_CONTENT_LENGTH);
+	os_memcpy(pos, str_size, size_size);
+	pos += size_size;
+	os_memcpy(pos, HTTP_HEADER_CONTENT_TYPE, HTTP_CONST_SIZE(HTTP_HEADER_CONTENT_TYPE));
+	pos += HTTP_CONST_SIZE(HTTP_HEADER_CONTENT_TYPE);
+	os_memcpy(pos, http_mime_types[mime].type, http_mime_types[mime].type_size);
+	pos += http_mime_types[mime].type_size;
+	os_memcpy(pos, HTTP_HEADERS_END, HTTP_CONST_SIZE(HTTP_HEADERS_END));
 
-	//Send end of headers.
-	ret += http_send(request->connection, "\r\n", 2);
-
-	return(ret);
+	return(ret + header_size);
 }
 
 /**
  * @brief Buffer some data for sending via TCP.
  * 
+ * The data is copied right away, use this for small fragments and data
+ * that will not stay around until the buffer is send.
+ * 
  * @note Can as maximum send #HTTP_SEND_BUFFER_SIZE bytes.
  * 
  * @param connection A pointer to the connection to use to send the data.
@@ -198,11 +360,92 @@ signed int http_send_default_headers(
  */
 size_t http_send(struct tcp_connection *connection, char *data, size_t size)
 {
-    struct http_request *request;
-    size_t buffer_free;
-    
-    debug("Buffering %d bytes of TCP data (%p using %p),\n", size, data, connection);
+	char *pos;
+	
+	debug("Buffering %d bytes of TCP data (%p using %p),\n", size, data, connection);
+	pos = reserve(connection, size);
+	if (!pos)
+	{
+		return(0);
+	}
+	os_memcpy(pos, data, size);
+	
+	return(size);
+}
+
+/**
+ * @brief Copy the data of a segment into its place in the send buffer.
+ * 
+ * @param segment The segment.
+ */
+static void fill_segment(struct http_segment *segment)
+{
+	switch (segment->type)
+	{
+		case HTTP_SEGMENT_RAM:
+			os_memcpy(segment->pos, segment->data, segment->size);
+			http_send_counters.copied += segment->size;
+			break;
+		case HTTP_SEGMENT_FLASH:
+			amemcpy((unsigned char *)segment->pos,
+					(unsigned char *)segment->data, segment->size);
+			http_send_counters.copied += segment->size;
+			break;
+		case HTTP_SEGMENT_FILE:
+			fs_read(segment->pos, segment->size, sizeof(char), segment->file);
+			http_send_counters.read += segment->size;
+			break;
+		default:
+			warn("Unknown segment type %d.\n", segment->type);
+	}
+}
+
+/**
+ * @brief Copy all referenced data into the send buffer now.
+ * 
+ * Use this before reading back data from the send buffer.
+ * 
+ * @param request The request of the response.
+ */
+void http_fill_segments(struct http_request *request)
+{
+	unsigned char i;
+	
+	for (i = 0; i < request->response.n_segments; i++)
+	{
+		fill_segment(&request->response.segments[i]);
+	}
+	request->response.n_segments = 0;
+}
+
+/**
+ * @brief Reserve space in the send buffer for data that is copied when sending.
+ * 
+ * If all segments are in use, the data is copied right away.
+ * 
+ * @param connection A pointer to the connection to use to send the data.
+ * @param type Type of the data, see #http_segment_types.
+ * @param data Pointer to the data, if not a file.
+ * @param file File to read, if type is #HTTP_SEGMENT_FILE.
+ * @param size Size (in bytes) of the data to send.
+ * @return Number of bytes buffered.
+ */
+static size_t add_segment(struct tcp_connection *connection,
+						  unsigned char type, const char *data,
+						  FS_FILE_H file, size_t size)
+{
+	struct http_request *request;
+	struct http_segment *segment;
+	struct http_segment temp;
+	size_t buffer_free;
+	
+	debug("Referencing %d bytes of TCP data (%p using %p),\n", size, data, connection);
 	request = connection->user;
+	if (!request->response.send_buffer)
+	{
+		warn("No send buffer.\n");
+		return(0);
+	}
 	
 	buffer_free = HTTP_SEND_BUFFER_SIZE - (request->response.send_buffer_pos - request->response.send_buffer);
 	if (buffer_free < size)
@@ -210,27 +453,119 @@ size_t http_send(struct tcp_connection *connection, char *data, size_t size)
 		debug(" Send buffer to small for %d bytes, currently %d bytes free.\n", size, buffer_free);
 		return(0);
 	}
-	os_memcpy(request->response.send_buffer_pos, data, size);
+	if (request->response.n_segments < HTTP_SEND_SEGMENTS)
+	{
+		segment = &request->response.segments[request->response.n_segments++];
+	}
+	else
+	{
+		debug(" No free segments, copying.\n");
+		segment = &temp;
+	}
+	segment->type = type;
+	segment->pos = request->response.send_buffer_pos;
+	segment->size = size;
+	segment->data = data;
+	segment->file = file;
+	if (segment == &temp)
+	{
+		fill_segment(segment);
+	}
 	request->response.send_buffer_pos += size;
 	debug(" Buffer free %d.\n", buffer_free - size);
 	
 	return(size);
 }
 
+/**
+ * @brief Buffer a reference to some data for sending via TCP.
+ * 
+ * The data is not copied until the buffer is send, and not at all, if
+ * it is all there is to send. *The data must stay around until the
+ * handler is called again.*
+ * 
+ * @param connection A pointer to the connection to use to send the data.
+ * @param data A pointer to the data to send.
+ * @param size Size (in bytes) of the data to send.
+ * @return Number of bytes buffered.
+ */
+size_t http_send_ref(struct tcp_connection *connection, const char *data,
+					 size_t size)
+{
+	if (size < HTTP_SEGMENT_MIN_SIZE)
+	{
+		return(http_send(connection, (char *)data, size));
+	}
+	return(add_segment(connection, HTTP_SEGMENT_RAM, data, 0, size));
+}
+
+/**
+ * @brief Buffer a reference to data in memory mapped flash.
+ * 
+ * The data is copied using aligned reads, when the buffer is send.
+ * 
+ * @param connection A pointer to the connection to use to send the data.
+ * @param data A pointer to the data to send.
+ * @param size Size (in bytes) of the data to send.
+ * @return Number of bytes buffered.
+ */
+size_t http_send_flash(struct tcp_connection *connection, const char *data,
+					   size_t size)
+{
+	return(add_segment(connection, HTTP_SEGMENT_FLASH, data, 0, size));
+}
+
+/**
+ * @brief Buffer data from a file.
+ * 
+ * The data is read directly into the send buffer, when it is send. The
+ * file must not be read or closed before then.
+ * 
+ * @param connection A pointer to the connection to use to send the data.
+ * @param file The file to read from.
+ * @param size Size (in bytes) of the data to send.
+ * @return Number of bytes buffered.
+ */
+size_t http_send_file(struct tcp_connection *connection, FS_FILE_H file,
+					  size_t size)
+{
+	return(add_segment(connection, HTTP_SEGMENT_FILE, NULL, file, size));
+}
+
 /**
  * @brief Send the waiting buffer.
  * 
+ * Referenced data is copied into the buffer first, unless a single
+ * segment in RAM is all there is, then it is passed on as is.
+ * 
  * @return true if nothing went wrong.
  */
 static bool send_buffer(struct http_request *request)
 {
+	struct http_segment *segment = request->response.segments;
 	size_t buffer_use;
+	unsigned char i;
 
 	debug("Sending buffer %p using connection %p.\n", request->response.send_buffer, request->connection);
 	buffer_use = request->response.send_buffer_pos - request->response.send_buffer;
 	
 	if (buffer_use)
 	{
+		if ((request->response.n_segments == 1) &&
+			(segment->type == HTTP_SEGMENT_RAM) &&
+			(segment->size == buffer_use))
+		{
+			debug(" Sending %d referenced bytes as is.\n", buffer_use);
+			request->response.n_segments = 0;
+			http_send_counters.referenced += buffer_use;
+			return(tcp_send(request->connection, (char *)segment->data, buffer_use));
+		}
+		for (i = 0; i < request->response.n_segments; i++)
+		{
+			fill_segment(segment++);
+		}
+		request->response.n_segments = 0;
+		debug(" Copied %lu bytes in total.\n", http_send_counters.copied);
 		return(tcp_send(request->connection, request->response.send_buffer, buffer_use));
 	}
 	debug( "Buffer empty.\n");
@@ -264,6 +599,10 @@ signed int http_handle_response(struct http_request *request)
 		if (ret > 0)
 		{
 			debug(" Data has been buffered.\n");
+			if (!request->phase_time[HTTP_PHASE_QUEUED])
+			{
+				http_latency_mark(request, HTTP_PHASE_QUEUED);
+			}
 			if (!send_buffer(request))
 			{
 				debug(" Couldn't send buffer.\n");
@@ -274,11 +613,20 @@ signed int http_handle_response(struct http_request *request)
 		if (ret == RESPONSE_DONE_FINAL)
 		{
 			debug(" Handler is done and no new handler is to be called.\n");
+			//Done sending, count times and log.
+			http_latency_done(request);
+			http_log_request(request);
+			//Give the client a moment to close the connection.
+			tcp_set_timeout(request->connection, HTTP_TIMEOUT_IDLE);
+			//Unless it is still sending a body, that is not going to be read.
+			if (request->body_received < request->content_length)
+			{
+				tcp_expire(request->connection);
+			}
 			//Don't leave the user pointer dangling.
 			request->connection->user = NULL;
+			http_release_send_buffer(request);
 			http_free_request(request);
-			//Done sending, print log line.
-			http_print_clf_status(request);
 			return(RESPONSE_DONE_FINAL);
 		}
 		//Stop but do not clean up.
@@ -289,9 +637,40 @@ signed int http_handle_response(struct http_request *request)
 		}
 		debug(" Handler is done, finding next handler.\n");
 		//Find next handler.
-		request->response.handler = http_get_handler(request, request->response.handler);
+		request->response.handler = http_get_handler(request, request->response.route);
 	}
-	//Done sending, print log line.
-	http_print_clf_status(request);
+	http_release_send_buffer(request);
+	//Done sending, count times and log.
+	http_latency_done(request);
+	http_log_request(request);
+	tcp_set_timeout(request->connection, HTTP_TIMEOUT_IDLE);
 	return(RESPONSE_DONE_FINAL);
 }
+
+/**
+ * @brief Give up on a request, whose connection is gone.
+ * 
+ * Lets a handler, that has started responding, free its data, and frees
+ * the request.
+ * 
+ * @param request The request.
+ */
+void http_abort_response(struct http_request *request)
+{
+	if (!request)
+	{
+		return;
+	}
+	debug("Aborting response to %p.\n", request);
+	if ((request->response.handler) &&
+		(request->response.state != HTTP_STATE_NONE))
+	{
+		//Handlers free their data when done.
+		request->response.state = HTTP_STATE_DONE;
+		request->response.handler(request);
+	}
+	http_log_request(request);
+	request->connection->user = NULL;
+	http_release_send_buffer(request);
+	http_free_request(request);
+}
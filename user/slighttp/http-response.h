@@ -36,6 +36,10 @@
 #define HTTP_STATUS_LINE(CODE, MSG) HTTP_STATUS_HTTP_VERSION " " CODE " " MSG "\r\n"
 
 //Predefined response status-lines.
+/**
+ * @brief HTTP 101 Switching protocols response.
+ */
+#define HTTP_STATUS_101 HTTP_STATUS_LINE("101", "Switching Protocols")
 /**
  * @brief HTTP 200 OK response.
  */
@@ -60,6 +64,10 @@
  * @brief HTTP 405 method not allowed response.
  */
 #define HTTP_STATUS_405 HTTP_STATUS_LINE("405", "Method Not Allowed")
+/**
+ * @brief HTTP 413 Payload too large response.
+ */
+#define HTTP_STATUS_413 HTTP_STATUS_LINE("413", "Payload Too Large")
 /**
  * @brief HTTP 500 Internal server error..
  */
@@ -68,6 +76,33 @@
  * @brief HTTP 501 Not implemented response.
  */
 #define HTTP_STATUS_501 HTTP_STATUS_LINE("501", "Not Implemented")
+/**
+ * @brief HTTP 503 Service unavailable response.
+ */
+#define HTTP_STATUS_503 HTTP_STATUS_LINE("503", "Service Unavailable")
+
+/**
+ * @brief Length of a string constant, without the zero byte.
+ */
+#define HTTP_CONST_SIZE(STR) (sizeof(STR) - 1)
+
+//Header templates.
+/**
+ * @brief Headers that are the same in every response.
+ */
+#define HTTP_HEADERS_FIXED "Connection: close\r\nServer: " HTTP_SERVER_NAME "\r\n"
+/**
+ * @brief Start of the `Content-Length` header.
+ */
+#define HTTP_HEADER_CONTENT_LENGTH "Content-Length: "
+/**
+ * @brief End of the `Content-Length` header, and start of `Content-Type`.
+ */
+#define HTTP_HEADER_CONTENT_TYPE "\r\nContent-Type: "
+/**
+ * @brief End of the last header, and of the headers.
+ */
+#define HTTP_HEADERS_END "\r\n\r\n"
 
 //Predefined HTML for responses
 /**
@@ -100,6 +135,16 @@
  */
 #define HTTP_501_HTML               "<!DOCTYPE html><head><title>Resource not found.</title></head><body><h1>501 Not Implemented</h1><br />Don't know what to say.</body></html>"
 #define HTTP_501_HTML_LENGTH		139
+/**
+ * @brief HTTP 413 response HTML.
+ */
+#define HTTP_413_HTML               "<!DOCTYPE html><head><title>Payload Too Large.</title></head><body><h1>413 Payload Too Large</h1><br />That is more than I can take.</body></html>"
+#define HTTP_413_HTML_LENGTH		146
+/**
+ * @brief HTTP 503 response HTML.
+ */
+#define HTTP_503_HTML               "<!DOCTYPE html><head><title>Service Unavailable.</title></head><body><h1>503 Service Unavailable</h1><br />Too busy, try again later.</body></html>"
+#define HTTP_503_HTML_LENGTH		147
 /**
  * @brief HTTP default response HTML.
  */
@@ -107,13 +152,39 @@
 #define HTTP_ERROR_HTML_END			".</body></html>"
 #define HTTP_ERROR_HTML_LENGTH		105
 
+/**
+ * @brief Counters of data passing through the send buffer.
+ */
+struct http_send_stats
+{
+	/**
+	 * @brief Bytes copied into the send buffer.
+	 */
+	unsigned long copied;
+	/**
+	 * @brief Bytes passed to the TCP stack without copying.
+	 */
+	unsigned long referenced;
+	/**
+	 * @brief Bytes read directly from files into the send buffer.
+	 */
+	unsigned long read;
+};
+
+extern struct http_send_stats http_send_counters;
+
+extern bool http_acquire_send_buffer(struct http_request *request);
+extern void http_release_send_buffer(struct http_request *request);
+extern unsigned char http_send_buffers_free(void);
 extern unsigned char http_send_status_line(
 	struct tcp_connection *connection, unsigned short status_code);
 extern unsigned short http_send_header(
 	struct tcp_connection *connection, char *name, char *value);
 extern signed int http_send_default_headers(
-	struct http_request *request, size_t size, char *mime);
+	struct http_request *request, size_t size, unsigned char mime);
+extern void http_fill_segments(struct http_request *request);
 extern void http_process_response(struct tcp_connection *connection);
 extern signed int http_handle_response(struct http_request *request);
+extern void http_abort_response(struct http_request *request);
 
 #endif //HTTP_RESPONSE_H
@@ -0,0 +1,243 @@
+/** @file http-sched.c
+ *
+ * @brief Scheduling of responses across connections.
+ * 
+ * Responses waiting to produce output are queued by priority class. The
+ * classes are served round robin, each getting up to its weight of
+ * turns per round, highest priority first. A response gets a send buffer
+ * from the pool for its turn, and is queued again when it has been sent.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "http.h"
+#include "http-response.h"
+#include "http-handler.h"
+#include "http-sched.h"
+
+/**
+ * @brief Names of the priority classes.
+ */
+const char *http_sched_class_names[] = {"control", "bulk"};
+
+/**
+ * @brief Statistics of each priority class.
+ */
+struct http_sched_stats http_sched_stats[HTTP_SCHED_CLASSES];
+
+/**
+ * @brief Turns per round of each class.
+ */
+static const unsigned char weights[HTTP_SCHED_CLASSES] =
+{
+	HTTP_SCHED_CONTROL_WEIGHT,
+	HTTP_SCHED_BULK_WEIGHT
+};
+
+/**
+ * @brief Turns left in this round of each class.
+ */
+static unsigned char credits[HTTP_SCHED_CLASSES];
+
+/**
+ * @brief First waiting response of each class.
+ */
+static struct http_request *queue_first[HTTP_SCHED_CLASSES];
+
+/**
+ * @brief Last waiting response of each class.
+ */
+static struct http_request *queue_last[HTTP_SCHED_CLASSES];
+
+/**
+ * @brief Set while the scheduler is running.
+ */
+static bool running = false;
+
+/**
+ * @brief Queue a response for its next turn.
+ * 
+ * @param request The request of the response.
+ */
+void http_sched_add(struct http_request *request)
+{
+	unsigned char class = request->sched_class;
+	
+	if (request->sched_queued)
+	{
+		return;
+	}
+	debug("Scheduling request %p in class %s.\n", request,
+		  http_sched_class_names[class]);
+	request->sched_queued = true;
+	request->sched_next = NULL;
+	request->sched_time = system_get_time();
+	if (queue_last[class])
+	{
+		queue_last[class]->sched_next = request;
+	}
+	else
+	{
+		queue_first[class] = request;
+	}
+	queue_last[class] = request;
+	if (++http_sched_stats[class].depth > http_sched_stats[class].max_depth)
+	{
+		http_sched_stats[class].max_depth = http_sched_stats[class].depth;
+	}
+}
+
+/**
+ * @brief Take a response out of the scheduler.
+ * 
+ * Used when the connection is gone.
+ * 
+ * @param request The request of the response.
+ */
+void http_sched_remove(struct http_request *request)
+{
+	unsigned char class = request->sched_class;
+	struct http_request **link = &queue_first[class];
+	struct http_request *prev = NULL;
+	
+	request->sched_sending = false;
+	http_release_send_buffer(request);
+	if (!request->sched_queued)
+	{
+		return;
+	}
+	while (*link)
+	{
+		if (*link == request)
+		{
+			*link = request->sched_next;
+			if (queue_last[class] == request)
+			{
+				queue_last[class] = prev;
+			}
+			http_sched_stats[class].depth--;
+			break;
+		}
+		prev = *link;
+		link = &(*link)->sched_next;
+	}
+	request->sched_queued = false;
+}
+
+/**
+ * @brief Tell the scheduler that the data of a response has been sent.
+ * 
+ * @param request The request of the response.
+ */
+void http_sched_sent(struct http_request *request)
+{
+	request->sched_sending = false;
+	http_release_send_buffer(request);
+	http_sched_add(request);
+}
+
+/**
+ * @brief Get the response that has the next turn.
+ * 
+ * @return The request of the response, or NULL if none are waiting.
+ */
+static struct http_request *pick(void)
+{
+	struct http_request *request;
+	unsigned char class;
+	unsigned char round;
+	uint32 wait;
+	
+	for (round = 0; round < 2; round++)
+	{
+		for (class = 0; class < HTTP_SCHED_CLASSES; class++)
+		{
+			request = queue_first[class];
+			if ((request) && (credits[class]))
+			{
+				credits[class]--;
+				queue_first[class] = request->sched_next;
+				if (!queue_first[class])
+				{
+					queue_last[class] = NULL;
+				}
+				request->sched_queued = false;
+				wait = system_get_time() - request->sched_time;
+				http_sched_stats[class].depth--;
+				http_sched_stats[class].served++;
+				http_sched_stats[class].total_wait += wait;
+				if (wait > http_sched_stats[class].max_wait)
+				{
+					http_sched_stats[class].max_wait = wait;
+				}
+				return(request);
+			}
+		}
+		//Start a new round.
+		for (class = 0; class < HTTP_SCHED_CLASSES; class++)
+		{
+			credits[class] = weights[class];
+		}
+	}
+	return(NULL);
+}
+
+/**
+ * @brief Let waiting responses produce output, while there is room.
+ */
+void http_sched_run(void)
+{
+	struct http_request *request;
+	signed int ret;
+	
+	//Responses that finish, may end up back here.
+	if (running)
+	{
+		return;
+	}
+	running = true;
+	//Waiting for a send buffer, is waiting in line.
+	while (http_send_buffers_free())
+	{
+		request = pick();
+		if (!request)
+		{
+			break;
+		}
+		debug("Serving request %p.\n", request);
+		http_acquire_send_buffer(request);
+		ret = http_handle_response(request);
+		debug(" Handler return value: %d.\n", ret);
+		//The request is gone, if the response is done.
+		if (ret > 0)
+		{
+			//The buffer is kept until the data has been sent.
+			request->sched_sending = true;
+		}
+		else if (ret != RESPONSE_DONE_FINAL)
+		{
+			http_release_send_buffer(request);
+		}
+	}
+	running = false;
+}
@@ -0,0 +1,98 @@
+/** @file http-sched.h
+ *
+ * @brief Scheduling of responses across connections.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */ 
+#ifndef HTTP_SCHED_H
+#define HTTP_SCHED_H
+
+#include "c_types.h"
+#include "http.h"
+
+#ifndef HTTP_SCHED_CONTROL_WEIGHT
+/**
+ * @brief Responses of the control class served per round.
+ */
+#define HTTP_SCHED_CONTROL_WEIGHT 4
+#endif
+
+#ifndef HTTP_SCHED_BULK_WEIGHT
+/**
+ * @brief Responses of the bulk class served per round.
+ */
+#define HTTP_SCHED_BULK_WEIGHT 1
+#endif
+
+/**
+ * @brief Priority classes of responses, highest priority first.
+ */
+enum http_sched_classes
+{
+	/**
+	 * @brief REST and other control routes, event streams and WebSockets.
+	 */
+	HTTP_SCHED_CONTROL = 0,
+	/**
+	 * @brief Static files and everything else.
+	 */
+	HTTP_SCHED_BULK,
+	/**
+	 * @brief Number of classes.
+	 */
+	HTTP_SCHED_CLASSES
+};
+
+/**
+ * @brief Statistics of a priority class.
+ */
+struct http_sched_stats
+{
+	/**
+	 * @brief Number of responses waiting.
+	 */
+	unsigned short depth;
+	/**
+	 * @brief Highest number of responses waiting.
+	 */
+	unsigned short max_depth;
+	/**
+	 * @brief Number of times a response has been served.
+	 */
+	unsigned long served;
+	/**
+	 * @brief Total time waited in micro seconds.
+	 */
+	unsigned long total_wait;
+	/**
+	 * @brief Longest time waited in micro seconds.
+	 */
+	unsigned long max_wait;
+};
+
+extern const char *http_sched_class_names[];
+extern struct http_sched_stats http_sched_stats[HTTP_SCHED_CLASSES];
+
+extern void http_sched_add(struct http_request *request);
+extern void http_sched_remove(struct http_request *request);
+extern void http_sched_sent(struct http_request *request);
+extern void http_sched_run(void);
+
+#endif //HTTP_SCHED_H
@@ -0,0 +1,318 @@
+/** @file http-sse.c
+ *
+ * @brief Server-Sent Events stream.
+ *
+ * A GET request to the event stream keeps the connection open, and
+ * events are pushed to it as they happen, instead of having the client
+ * poll for changes. Each stream has a small buffer of events waiting to
+ * be sent, and is put in the response scheduler when there is something
+ * to send. Streams with nothing to say, get a comment now and then, to
+ * keep the connection from timing out.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ *
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "os_type.h"
+#include "user_config.h"
+#include "http.h"
+#include "http-handler.h"
+#include "http-response.h"
+#include "http-sched.h"
+#include "http-sse.h"
+
+/**
+ * @brief Headers of an event stream, and the reconnect time.
+ */
+#define HTTP_SSE_HEADERS "Content-Type: text/event-stream\r\n" \
+						 "Cache-Control: no-cache\r\n\r\n" \
+						 "retry: " HTTP_SSE_RETRY "\n\n"
+
+/**
+ * @brief Comment sent to keep an idle stream open.
+ */
+#define HTTP_SSE_COMMENT ":\n\n"
+
+/**
+ * @brief An open event stream.
+ */
+struct http_sse_subscriber
+{
+	/**
+	 * @brief The request of the stream, NULL if the slot is free.
+	 */
+	struct http_request *request;
+	/**
+	 * @brief Bytes waiting in #events.
+	 */
+	size_t pending;
+	/**
+	 * @brief Events waiting to be sent.
+	 */
+	char events[HTTP_SSE_BUFFER_SIZE];
+};
+
+/**
+ * @brief Number of events dropped because a stream could not keep up.
+ */
+unsigned long http_sse_dropped = 0;
+
+/**
+ * @brief The streams.
+ */
+static struct http_sse_subscriber subscribers[HTTP_SSE_SUBSCRIBERS];
+
+/**
+ * @brief Number of open streams.
+ */
+static unsigned char n_subscribers = 0;
+
+/**
+ * @brief Timer for the keep alive comments.
+ */
+static os_timer_t keepalive_timer;
+
+/**
+ * @brief Find the stream of a request.
+ *
+ * @param request The request, or NULL to find a free slot.
+ * @return The stream, or NULL if not found.
+ */
+static struct http_sse_subscriber *find(struct http_request *request)
+{
+	unsigned char i;
+
+	for (i = 0; i < HTTP_SSE_SUBSCRIBERS; i++)
+	{
+		if (subscribers[i].request == request)
+		{
+			return(&subscribers[i]);
+		}
+	}
+	return(NULL);
+}
+
+/**
+ * @brief Add data to the events waiting on a stream.
+ *
+ * @param subscriber The stream.
+ * @param data The data.
+ * @param size Size of the data.
+ */
+static void queue(struct http_sse_subscriber *subscriber, const char *data,
+				  size_t size)
+{
+	if ((subscriber->pending + size) > HTTP_SSE_BUFFER_SIZE)
+	{
+		warn("Event stream %p is full, dropping event.\n",
+			 subscriber->request);
+		http_sse_dropped++;
+		return;
+	}
+	os_memcpy(subscriber->events + subscriber->pending, data, size);
+	subscriber->pending += size;
+	//The sent call back will queue it, if data is on the way.
+	if (!subscriber->request->sched_sending)
+	{
+		http_sched_add(subscriber->request);
+	}
+}
+
+/**
+ * @brief Send a comment on streams that have nothing waiting.
+ *
+ * @param arg Not used.
+ */
+static void keepalive(void *arg)
+{
+	unsigned char i;
+
+	debug("Event stream keep alive.\n");
+	for (i = 0; i < HTTP_SSE_SUBSCRIBERS; i++)
+	{
+		if ((subscribers[i].request) && (!subscribers[i].pending))
+		{
+			queue(&subscribers[i], HTTP_SSE_COMMENT,
+				  HTTP_CONST_SIZE(HTTP_SSE_COMMENT));
+		}
+	}
+	http_sched_run();
+}
+
+/**
+ * @brief Initialise the event streams.
+ */
+void http_sse_init(void)
+{
+	os_timer_disarm(&keepalive_timer);
+	os_timer_setfn(&keepalive_timer, (os_timer_func_t *)keepalive, NULL);
+	os_memset(subscribers, 0, sizeof(subscribers));
+	n_subscribers = 0;
+}
+
+/**
+ * @brief Handler for the event stream.
+ *
+ * Sends the headers, and keeps the request around as a stream. Responds
+ * with status 503 if all streams are in use.
+ *
+ * @param request The request.
+ * @return Size of the data sent, or a response done code.
+ */
+signed int http_sse_handler(struct http_request *request)
+{
+	struct http_sse_subscriber *subscriber;
+	signed int ret;
+
+	switch (request->response.state)
+	{
+		case HTTP_STATE_NONE:
+			debug("Event stream request %p.\n", request);
+			subscriber = NULL;
+			if (request->type != HTTP_HEAD)
+			{
+				subscriber = find(NULL);
+				if (!subscriber)
+				{
+					warn("No free event streams.\n");
+					request->response.status_code = 503;
+					return(RESPONSE_DONE_CONTINUE);
+				}
+			}
+			ret = http_send_status_line(request->connection, 200);
+			ret += http_send_ref(request->connection, HTTP_HEADERS_FIXED,
+								 HTTP_CONST_SIZE(HTTP_HEADERS_FIXED));
+			ret += http_send_ref(request->connection, HTTP_SSE_HEADERS,
+								 HTTP_CONST_SIZE(HTTP_SSE_HEADERS));
+			if (!subscriber)
+			{
+				request->response.state = HTTP_STATE_DONE;
+				return(ret);
+			}
+			subscriber->request = request;
+			subscriber->pending = 0;
+			tcp_set_timeout(request->connection, HTTP_TIMEOUT_STREAM);
+			//Events are small and wanted now, keep them ahead of files.
+			request->sched_class = HTTP_SCHED_CONTROL;
+			if (!n_subscribers++)
+			{
+				os_timer_arm(&keepalive_timer, HTTP_SSE_KEEPALIVE, 1);
+			}
+			request->response.state = HTTP_STATE_MESSAGE;
+			return(ret);
+		case HTTP_STATE_MESSAGE:
+			subscriber = find(request);
+			if ((!subscriber) || (!subscriber->pending))
+			{
+				//Wait for the next event.
+				return(RESPONSE_DONE_NO_DEALLOC);
+			}
+			debug("Sending %d bytes of events to %p.\n",
+				  subscriber->pending, request);
+			ret = http_send(request->connection, subscriber->events,
+							subscriber->pending);
+			subscriber->pending = 0;
+			return(ret);
+		default:
+			return(RESPONSE_DONE_FINAL);
+	}
+}
+
+/**
+ * @brief Send an event to all streams.
+ *
+ * @param event Name of the event.
+ * @param data Data of the event, must be a single line.
+ */
+void http_sse_send(const char *event, const char *data)
+{
+	char buffer[HTTP_SSE_BUFFER_SIZE];
+	size_t event_size, data_size, size;
+	unsigned char i;
+
+	if (!n_subscribers)
+	{
+		return;
+	}
+	debug("Sending event %s: %s.\n", event, data);
+	event_size = os_strlen(event);
+	data_size = os_strlen(data);
+	size = HTTP_CONST_SIZE("event: \ndata: \n\n") + event_size + data_size;
+	if (size > HTTP_SSE_BUFFER_SIZE)
+	{
+		warn("Event %s is too large.\n", event);
+		http_sse_dropped++;
+		return;
+	}
+	os_memcpy(buffer, "event: ", 7);
+	os_memcpy(buffer + 7, event, event_size);
+	os_memcpy(buffer + 7 + event_size, "\ndata: ", 7);
+	os_memcpy(buffer + 14 + event_size, data, data_size);
+	os_memcpy(buffer + 14 + event_size + data_size, "\n\n", 2);
+	for (i = 0; i < HTTP_SSE_SUBSCRIBERS; i++)
+	{
+		if (subscribers[i].request)
+		{
+			queue(&subscribers[i], buffer, size);
+		}
+	}
+	http_sched_run();
+}
+
+/**
+ * @brief Close the stream of a request.
+ *
+ * Called when the connection is gone.
+ *
+ * @param request The request.
+ * @return True if the request was a stream, and the caller must free it.
+ */
+bool http_sse_remove(struct http_request *request)
+{
+	struct http_sse_subscriber *subscriber;
+
+	if (!request)
+	{
+		return(false);
+	}
+	subscriber = find(request);
+	if (!subscriber)
+	{
+		return(false);
+	}
+	debug("Closing event stream %p.\n", request);
+	subscriber->request = NULL;
+	subscriber->pending = 0;
+	if (!--n_subscribers)
+	{
+		os_timer_disarm(&keepalive_timer);
+	}
+	return(true);
+}
+
+/**
+ * @brief Get the number of open streams.
+ *
+ * @return Number of open streams.
+ */
+unsigned char http_sse_subscribers(void)
+{
+	return(n_subscribers);
+}
@@ -0,0 +1,68 @@
+/** @file http-sse.h
+ *
+ * @brief Server-Sent Events stream.
+ *
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ *
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#ifndef HTTP_SSE_H
+#define HTTP_SSE_H
+
+#include "c_types.h"
+#include "http.h"
+
+#ifndef HTTP_SSE_SUBSCRIBERS
+/**
+ * @brief Maximum number of open event streams.
+ */
+#define HTTP_SSE_SUBSCRIBERS 2
+#endif
+
+#ifndef HTTP_SSE_BUFFER_SIZE
+/**
+ * @brief Room for events waiting to be sent, for each stream.
+ */
+#define HTTP_SSE_BUFFER_SIZE 192
+#endif
+
+#ifndef HTTP_SSE_KEEPALIVE
+/**
+ * @brief Time in ms between comments sent on idle streams.
+ *
+ * Must be less than #HTTP_TIMEOUT_STREAM.
+ */
+#define HTTP_SSE_KEEPALIVE 20000
+#endif
+
+#ifndef HTTP_SSE_RETRY
+/**
+ * @brief Time in ms the client waits before reconnecting a lost stream.
+ */
+#define HTTP_SSE_RETRY "3000"
+#endif
+
+extern unsigned long http_sse_dropped;
+
+extern void http_sse_init(void);
+extern signed int http_sse_handler(struct http_request *request);
+extern void http_sse_send(const char *event, const char *data);
+extern bool http_sse_remove(struct http_request *request);
+extern unsigned char http_sse_subscribers(void);
+
+#endif //HTTP_SSE_H
@@ -25,7 +25,6 @@
 #include "c_types.h"
 #include "osapi.h"
 #include "user_config.h"
-#include "net/net.h"
 #include "net/tcp.h"
 #include "http-common.h"
 #include "http-handler.h"
@@ -33,11 +32,12 @@
 #include "http-response.h"
 #include "http.h"
 #include "http-tcp.h"
-
-/**
- * @brief Ring buffer for incomming request, that are waiting for a response.
- */
-struct ring_buffer request_buffer;
+#include "http-sched.h"
+#include "http-latency.h"
+#include "http-log.h"
+#include "http-sse.h"
+#include "http-ws.h"
+#include "http-admit.h"
 
 /**
  * @brief Response handler mutex, add one when handling request, substract one when done.
@@ -57,15 +57,30 @@ void tcp_connect_cb(struct tcp_connection *connection)
     struct http_request *request;
     
     debug("HTTP new connection (%p).\n", connection);
+    tcp_set_timeout(connection, HTTP_TIMEOUT_HEADERS);
+    //Do not spend memory on a request that is going to be refused.
+    if (!http_admit(connection))
+    {
+		connection->user = NULL;
+		connection->refused = true;
+		return;
+	}
    
     //Allocate memory for the request data, and tie it to the connection.
     request = (struct http_request *)db_zalloc(sizeof(struct http_request), "request tcp_connect_cb"); 
     debug(" Allocated memory for request data: %p.\n", request);
-    //Reset send buffer position.
-    request->response.send_buffer_pos = request->response.send_buffer;
+    if (!request)
+    {
+		http_admit_shed.heap++;
+		connection->user = NULL;
+		connection->refused = true;
+		return;
+	}
     connection->user = request;
     request->connection = connection;
     request->response.status_code = 200;
+    arena_init(&request->arena, HTTP_ARENA_SIZE);
+    http_latency_mark(request, HTTP_PHASE_CONNECT);
 }
 
 /**
@@ -88,7 +103,19 @@ void tcp_reconnect_cb(struct tcp_connection *connection)
  */
 void tcp_disconnect_cb(struct tcp_connection *connection)
 {
+    struct http_request *request = connection->user;
+    
     debug("HTTP disconnect (%p).\n", connection);
+    http_admit_connections--;
+    //Do not serve a response on a connection that is gone.
+    if (request)
+    {
+		http_sched_remove(request);
+		http_sse_remove(request);
+		http_ws_remove(request);
+		http_abort_response(request);
+		http_sched_run();
+	}
 }
 
 /**
@@ -101,6 +128,25 @@ void tcp_write_finish_cb(struct tcp_connection *connection)
 	debug("Done writing (%p).\n", connection);
 }
 
+/**
+ * @brief Start responding to a request that has been received.
+ * 
+ * @param request The request.
+ */
+static void respond(struct http_request *request)
+{
+	//Errors found while receiving are answered right away.
+	if (request->response.status_code >= 400)
+	{
+		debug(" Error %d while receiving.\n", request->response.status_code);
+		request->response.handler = http_status_handler;
+	}
+	tcp_set_timeout(request->connection, HTTP_TIMEOUT_SEND);
+	//Wait for a turn to respond.
+	http_sched_add(request);
+	http_sched_run();
+}
+
 /**
  * @brief Called when data has been received.
  * 
@@ -110,12 +156,42 @@ void tcp_write_finish_cb(struct tcp_connection *connection)
  */
 void tcp_recv_cb(struct tcp_connection *connection)
 {
-	void *buffer_ptr;
-	signed int ret;
-	
 	struct http_request *request = connection->user;
+	size_t size;
 	
     debug("HTTP received (%p).\n", connection);
+    //Refused when connected, the 503 is only sent once.
+    if (connection->refused)
+    {
+		http_admit_refuse(connection);
+		return;
+	}
+    //The response is done, anything else is ignored.
+    if (!request)
+    {
+		debug(" No request, ignoring %d bytes.\n", connection->callback_data.length);
+		return;
+	}
+    //WebSocket frames are not HTTP.
+    if (http_ws_recv(request, connection->callback_data.data,
+					 connection->callback_data.length))
+    {
+		return;
+	}
+    if (!request->phase_time[HTTP_PHASE_RECV])
+    {
+		http_latency_mark(request, HTTP_PHASE_RECV);
+	}
+	//More of the message body.
+	if ((request->uri) && (request->body_received < request->content_length))
+	{
+		if (http_request_body(request, connection->callback_data.data,
+							  connection->callback_data.length))
+		{
+			respond(request);
+		}
+		return;
+	}
     if ((connection->callback_data.data == NULL) ||
 		(os_strlen(connection->callback_data.data) == 0) ||
 		(connection->callback_data.length == 0))
@@ -128,7 +204,8 @@ void tcp_recv_cb(struct tcp_connection *connection)
 	}
 
 	//A bad idea to parse later since the data may be gone.
-	if (!http_parse_request(connection, connection->callback_data.length))
+	size = http_parse_request(connection, connection->callback_data.length);
+	if (!size)
 	{
 		warn("Parsing failed.\n");
 		if (request->response.status_code < 399)
@@ -137,44 +214,36 @@ void tcp_recv_cb(struct tcp_connection *connection)
 			request->response.status_code = 400;
 		}
 	}
+	http_latency_mark(request, HTTP_PHASE_PARSED);
 	
 	//Get the first handler.
 	request->response.handler = http_get_handler(request, NULL);
+	http_latency_mark(request, HTTP_PHASE_ROUTED);
 
-	//Put in buffer if there is stuff there already.
-	if ((request_buffer.count > 0) || net_sending)
-	{
-		if (request_buffer.count < (HTTP_REQUEST_BUFFER_SIZE - 1))
-		{
-			debug(" Adding request to buffer.\n");
-			buffer_ptr = ring_push_back(&request_buffer);
-			*((struct tcp_connection **)buffer_ptr) = connection;
-			return;
-		}
-		else
-		{
-			error("Dumping request, no free buffers.\n");
-			return;
-		}
-	}
-	else
+	//Respond when the whole message body is here.
+	if (!http_request_body(request, connection->callback_data.data + size,
+						   connection->callback_data.length - size))
 	{
-		//Start response.
-		ret = http_handle_response(request);
-		debug(" Handler return value: %d.\n", ret);
+		tcp_set_timeout(connection, HTTP_TIMEOUT_BODY);
+		debug(" Waiting for %d bytes of message body.\n",
+			  request->content_length - request->body_received);
+		return;
 	}
+	respond(request);
     debug(" Request %p done.\n", request);
 }
 
 void tcp_sent_cb(struct tcp_connection *connection )
 {
 	struct http_request *request = connection->user;
-	signed int ret = 0;
-	void *connection_ptr;
 		
 	debug("HTTP send (%p).\n", connection);
-	//Reset send buffer.
-	request->response.send_buffer_pos = request->response.send_buffer;
+	//The 503 response to a refused request, or the end of a response, has been sent.
+	if (!request)
+	{
+		tcp_expire(connection);
+		return;
+	}
 	debug(" Response state: %d.\n", request->response.state);
 	
 	//Call handler again.
@@ -186,25 +255,8 @@ void tcp_sent_cb(struct tcp_connection *connection )
 		error(" No handler.\n");
 		return;
 	}
-	ret = http_handle_response(request);
-	debug(" Handler return value: %d.\n", ret);
-	
-	//Go on if no data was send.
-	if (ret <= 0)
-	{
-		//Answer buffered request.
-		debug(" %d buffered Requests.\n", request_buffer.count); 
-		if (request_buffer.count > 0)
-		{
-			debug(" Handling request from buffer.\n");
-			connection_ptr = ring_pop_front(&request_buffer);
-			if (connection_ptr)
-			{
-				request = (*((struct tcp_connection **)connection_ptr))->user;
-				ret = http_handle_response(request);
-				debug(" Handler return value: %d.\n", ret);
-				db_free(connection_ptr);
-			}
-		}
-	}
+	http_latency_sent(request);
+	//Wait for the next turn.
+	http_sched_sent(request);
+	http_sched_run();
 }
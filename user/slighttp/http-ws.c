@@ -0,0 +1,636 @@
+/** @file http-ws.c
+ *
+ * @brief WebSocket connections.
+ *
+ * A handler calls #http_ws_upgrade to turn the request into a
+ * WebSocket connection (RFC 6455). The request is then kept until the
+ * client disconnects. Received data is passed here instead of to the
+ * HTTP parser, and messages are passed to the callback of the handler.
+ * Frames to send are put in a small buffer for each connection, and
+ * the connection is put in the response scheduler to send them.
+ *
+ * Fragmented messages, and messages larger than the buffers, are not
+ * supported, and close the connection.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "os_type.h"
+#include "user_config.h"
+#include "tools/sha1.h"
+#include "tools/base64.h"
+#include "http.h"
+#include "http-common.h"
+#include "http-handler.h"
+#include "http-request.h"
+#include "http-response.h"
+#include "http-sched.h"
+#include "http-ws.h"
+
+/**
+ * @brief Appended to the key of the client, to get the accept value.
+ */
+#define HTTP_WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+/**
+ * @brief Headers of the upgrade response, up to the accept value.
+ */
+#define HTTP_WS_HEADERS "Upgrade: websocket\r\nConnection: Upgrade\r\n" \
+						"Sec-WebSocket-Accept: "
+
+/**
+ * @brief Size of the key sent by the client.
+ */
+#define HTTP_WS_KEY_SIZE 24
+
+/**
+ * @brief Frame opcodes.
+ */
+enum http_ws_opcodes
+{
+	/**
+	 * @brief Continuation of a fragmented message.
+	 */
+	HTTP_WS_CONTINUATION = 0x0,
+	/**
+	 * @brief Text message.
+	 */
+	HTTP_WS_TEXT = 0x1,
+	/**
+	 * @brief Binary message.
+	 */
+	HTTP_WS_BINARY = 0x2,
+	/**
+	 * @brief Close the connection.
+	 */
+	HTTP_WS_CLOSE = 0x8,
+	/**
+	 * @brief Ping.
+	 */
+	HTTP_WS_PING_FRAME = 0x9,
+	/**
+	 * @brief Answer to a ping.
+	 */
+	HTTP_WS_PONG = 0xA
+};
+
+/**
+ * @brief Close status for a protocol error.
+ */
+#define HTTP_WS_CLOSE_PROTOCOL 1002
+/**
+ * @brief Close status for data that is not supported.
+ */
+#define HTTP_WS_CLOSE_UNSUPPORTED 1003
+/**
+ * @brief Close status for a message that is too big.
+ */
+#define HTTP_WS_CLOSE_TOO_BIG 1009
+
+/**
+ * @brief Number of frames dropped because a send buffer was full.
+ */
+unsigned long http_ws_dropped = 0;
+
+/**
+ * @brief The connections.
+ */
+static struct http_ws connections[HTTP_WS_CONNECTIONS];
+
+/**
+ * @brief Number of open connections.
+ */
+static unsigned char n_connections = 0;
+
+/**
+ * @brief Timer for the pings.
+ */
+static os_timer_t ping_timer;
+
+/**
+ * @brief Find the WebSocket connection of a request.
+ *
+ * @param request The request, or NULL to find a free slot.
+ * @return The connection, or NULL if not found.
+ */
+static struct http_ws *find(struct http_request *request)
+{
+	unsigned char i;
+
+	for (i = 0; i < HTTP_WS_CONNECTIONS; i++)
+	{
+		if (connections[i].request == request)
+		{
+			return(&connections[i]);
+		}
+	}
+	return(NULL);
+}
+
+/**
+ * @brief Check if a header value has a token in its comma separated list.
+ * 
+ * The token is matched without regard to case.
+ * 
+ * @param value The header value.
+ * @param size Size of the value.
+ * @param token The token in lower case.
+ * @return True if the token is found.
+ */
+static bool has_token(const char *value, size_t size, const char *token)
+{
+	size_t token_size = os_strlen(token);
+	size_t i, j;
+	
+	i = 0;
+	while (i < size)
+	{
+		//Skip separators.
+		while ((i < size) && ((value[i] == ' ') || (value[i] == ',')))
+		{
+			i++;
+		}
+		for (j = 0; (j < token_size) && (i + j < size); j++)
+		{
+			if ((value[i + j] | 0x20) != token[j])
+			{
+				break;
+			}
+		}
+		if ((j == token_size) &&
+			((i + j == size) || (value[i + j] == ',') || (value[i + j] == ' ')))
+		{
+			return(true);
+		}
+		//Next token.
+		while ((i < size) && (value[i] != ','))
+		{
+			i++;
+		}
+	}
+	return(false);
+}
+
+/**
+ * @brief Put a frame in the send buffer of a connection.
+ * 
+ * @param ws The connection.
+ * @param opcode Opcode of the frame, see #http_ws_opcodes.
+ * @param data The payload.
+ * @param size Size of the payload.
+ * @return True if the frame was buffered.
+ */
+static bool queue_frame(struct http_ws *ws, unsigned char opcode,
+						const void *data, size_t size)
+{
+	unsigned char *pos;
+	unsigned char header_size;
+	
+	if (ws->closing)
+	{
+		debug("WebSocket %p is closing, not sending.\n", ws->request);
+		return(false);
+	}
+	header_size = (size < 126) ? 2 : 4;
+	if ((ws->pending + header_size + size) > HTTP_WS_BUFFER_SIZE)
+	{
+		warn("WebSocket %p send buffer is full, dropping frame.\n",
+			 ws->request);
+		http_ws_dropped++;
+		return(false);
+	}
+	pos = ws->out + ws->pending;
+	//Final fragment, no mask.
+	pos[0] = 0x80 | opcode;
+	if (header_size == 2)
+	{
+		pos[1] = size;
+	}
+	else
+	{
+		pos[1] = 126;
+		pos[2] = size >> 8;
+		pos[3] = size & 0xFF;
+	}
+	if (size)
+	{
+		os_memcpy(pos + header_size, data, size);
+	}
+	ws->pending += header_size + size;
+	if (opcode == HTTP_WS_CLOSE)
+	{
+		ws->closing = true;
+	}
+	//The sent call back will queue it, if data is on the way.
+	if (!ws->request->sched_sending)
+	{
+		http_sched_add(ws->request);
+	}
+	return(true);
+}
+
+/**
+ * @brief Start closing a connection.
+ * 
+ * The client closes the TCP connection, when it gets the close frame.
+ * 
+ * @param ws The connection.
+ * @param status Status code sent in the close frame.
+ */
+static void close_ws(struct http_ws *ws, unsigned short status)
+{
+	unsigned char payload[2];
+	
+	debug("Closing WebSocket %p, status %d.\n", ws->request, status);
+	payload[0] = status >> 8;
+	payload[1] = status & 0xFF;
+	queue_frame(ws, HTTP_WS_CLOSE, payload, 2);
+	ws->received = 0;
+}
+
+/**
+ * @brief Handle a frame at the start of the received data.
+ * 
+ * @param ws The connection.
+ * @param data The received data.
+ * @param size Size of the received data.
+ * @return Size of the frame, or 0 if it is not all here, or on errors.
+ */
+static size_t handle_frame(struct http_ws *ws, unsigned char *data,
+						   size_t size)
+{
+	unsigned char opcode;
+	unsigned char *payload;
+	size_t header_size = 2;
+	size_t length;
+	size_t i;
+	unsigned char saved;
+	
+	if (size < 2)
+	{
+		return(0);
+	}
+	opcode = data[0] & 0x0F;
+	length = data[1] & 0x7F;
+	//Clients must mask their frames.
+	if (!(data[1] & 0x80))
+	{
+		warn("Unmasked WebSocket frame.\n");
+		close_ws(ws, HTTP_WS_CLOSE_PROTOCOL);
+		return(0);
+	}
+	if (length == 126)
+	{
+		if (size < 4)
+		{
+			return(0);
+		}
+		length = (data[2] << 8) | data[3];
+		header_size = 4;
+	}
+	else if (length == 127)
+	{
+		close_ws(ws, HTTP_WS_CLOSE_TOO_BIG);
+		return(0);
+	}
+	//Masking key.
+	header_size += 4;
+	if ((header_size + length) > HTTP_WS_BUFFER_SIZE)
+	{
+		warn("WebSocket frame of %d bytes is too big.\n", length);
+		close_ws(ws, HTTP_WS_CLOSE_TOO_BIG);
+		return(0);
+	}
+	if (size < (header_size + length))
+	{
+		return(0);
+	}
+	payload = data + header_size;
+	for (i = 0; i < length; i++)
+	{
+		payload[i] ^= data[header_size - 4 + (i & 3)];
+	}
+	if ((!(data[0] & 0x80)) || (opcode == HTTP_WS_CONTINUATION))
+	{
+		warn("Fragmented WebSocket messages are not supported.\n");
+		close_ws(ws, HTTP_WS_CLOSE_UNSUPPORTED);
+		return(0);
+	}
+	debug("WebSocket frame, opcode 0x%x, %d bytes.\n", opcode, length);
+	switch (opcode)
+	{
+		case HTTP_WS_TEXT:
+		case HTTP_WS_BINARY:
+			//Zero terminate, the byte belongs to the next frame.
+			saved = payload[length];
+			payload[length] = '\0';
+			if (ws->message)
+			{
+				ws->message(ws, (char *)payload, length);
+			}
+			payload[length] = saved;
+			break;
+		case HTTP_WS_CLOSE:
+			//Answer with the same status.
+			queue_frame(ws, HTTP_WS_CLOSE, payload, (length < 2) ? 0 : 2);
+			break;
+		case HTTP_WS_PING_FRAME:
+			queue_frame(ws, HTTP_WS_PONG, payload, length);
+			break;
+		case HTTP_WS_PONG:
+			break;
+		default:
+			warn("Unknown WebSocket opcode 0x%x.\n", opcode);
+			close_ws(ws, HTTP_WS_CLOSE_PROTOCOL);
+			return(0);
+	}
+	return(header_size + length);
+}
+
+/**
+ * @brief Send a ping on connections that have nothing waiting.
+ *
+ * @param arg Not used.
+ */
+static void ping(void *arg)
+{
+	unsigned char i;
+
+	debug("WebSocket ping.\n");
+	for (i = 0; i < HTTP_WS_CONNECTIONS; i++)
+	{
+		if ((connections[i].request) && (!connections[i].pending))
+		{
+			queue_frame(&connections[i], HTTP_WS_PING_FRAME, NULL, 0);
+		}
+	}
+	http_sched_run();
+}
+
+/**
+ * @brief Initialise the WebSocket connections.
+ */
+void http_ws_init(void)
+{
+	os_timer_disarm(&ping_timer);
+	os_timer_setfn(&ping_timer, (os_timer_func_t *)ping, NULL);
+	os_memset(connections, 0, sizeof(connections));
+	n_connections = 0;
+}
+
+/**
+ * @brief Upgrade a request to a WebSocket connection.
+ * 
+ * Called by the handler of the route, every time the handler is
+ * called. Responds with status 400 if the request is not a valid
+ * upgrade request, and 503 if all connections are in use.
+ * 
+ * @param request The request.
+ * @param callback Called with the messages received.
+ * @return Size of the data sent, or a response done code.
+ */
+signed int http_ws_upgrade(struct http_request *request,
+						   http_ws_callback callback)
+{
+	struct sha1_context sha1;
+	unsigned char digest[SHA1_DIGEST_SIZE];
+	char accept[BASE64_SIZE(SHA1_DIGEST_SIZE) + 1];
+	struct http_ws *ws;
+	char *value;
+	size_t size;
+	signed int ret;
+	
+	switch (request->response.state)
+	{
+		case HTTP_STATE_NONE:
+			debug("WebSocket upgrade request %p.\n", request);
+			if (request->type != HTTP_GET)
+			{
+				request->response.status_code = 400;
+				return(RESPONSE_DONE_CONTINUE);
+			}
+			value = http_get_header(request, "Upgrade", &size);
+			if ((!value) || (!has_token(value, size, "websocket")))
+			{
+				request->response.status_code = 400;
+				return(RESPONSE_DONE_CONTINUE);
+			}
+			value = http_get_header(request, "Connection", &size);
+			if ((!value) || (!has_token(value, size, "upgrade")))
+			{
+				request->response.status_code = 400;
+				return(RESPONSE_DONE_CONTINUE);
+			}
+			value = http_get_header(request, "Sec-WebSocket-Version", &size);
+			if ((!value) || (size != 2) || (os_strncmp(value, "13", 2) != 0))
+			{
+				warn("Unsupported WebSocket version.\n");
+				request->response.status_code = 400;
+				return(RESPONSE_DONE_CONTINUE);
+			}
+			value = http_get_header(request, "Sec-WebSocket-Key", &size);
+			if ((!value) || (size != HTTP_WS_KEY_SIZE))
+			{
+				warn("Bad WebSocket key.\n");
+				request->response.status_code = 400;
+				return(RESPONSE_DONE_CONTINUE);
+			}
+			ws = find(NULL);
+			if (!ws)
+			{
+				warn("No free WebSocket connections.\n");
+				request->response.status_code = 503;
+				return(RESPONSE_DONE_CONTINUE);
+			}
+			//Accept value is base64(SHA-1(key + GUID)).
+			sha1_init(&sha1);
+			sha1_update(&sha1, value, HTTP_WS_KEY_SIZE);
+			sha1_update(&sha1, HTTP_WS_GUID, HTTP_CONST_SIZE(HTTP_WS_GUID));
+			sha1_final(&sha1, digest);
+			size = base64_encode(digest, SHA1_DIGEST_SIZE, accept);
+			
+			ret = http_send_status_line(request->connection, 101);
+			ret += http_send_ref(request->connection, HTTP_WS_HEADERS,
+								 HTTP_CONST_SIZE(HTTP_WS_HEADERS));
+			ret += http_send(request->connection, accept, size);
+			ret += http_send_ref(request->connection, HTTP_HEADERS_END,
+								 HTTP_CONST_SIZE(HTTP_HEADERS_END));
+			
+			os_memset(ws, 0, sizeof(struct http_ws));
+			ws->request = request;
+			ws->message = callback;
+			tcp_set_timeout(request->connection, HTTP_TIMEOUT_STREAM);
+			//Frames are small and wanted now, keep them ahead of files.
+			request->sched_class = HTTP_SCHED_CONTROL;
+			if (!n_connections++)
+			{
+				os_timer_arm(&ping_timer, HTTP_WS_PING, 1);
+			}
+			request->response.state = HTTP_STATE_MESSAGE;
+			return(ret);
+		case HTTP_STATE_MESSAGE:
+			ws = find(request);
+			if ((!ws) || (!ws->pending))
+			{
+				//Wait for something to send.
+				return(RESPONSE_DONE_NO_DEALLOC);
+			}
+			debug("Sending %d bytes of WebSocket frames to %p.\n",
+				  ws->pending, request);
+			ret = http_send(request->connection, (char *)ws->out, ws->pending);
+			ws->pending = 0;
+			return(ret);
+		default:
+			return(RESPONSE_DONE_FINAL);
+	}
+}
+
+/**
+ * @brief Handle data received on a connection.
+ * 
+ * @param request The request of the connection.
+ * @param data The received data.
+ * @param size Size of the data.
+ * @return True if the connection is a WebSocket, and the data has been
+ *         handled.
+ */
+bool http_ws_recv(struct http_request *request, char *data, size_t size)
+{
+	struct http_ws *ws;
+	size_t pos, used;
+	
+	if (!request)
+	{
+		return(false);
+	}
+	ws = find(request);
+	if (!ws)
+	{
+		return(false);
+	}
+	debug("WebSocket %p received %d bytes.\n", request, size);
+	//Waiting for the client to close the connection.
+	if (ws->closing)
+	{
+		return(true);
+	}
+	if ((ws->received + size) > HTTP_WS_BUFFER_SIZE)
+	{
+		warn("WebSocket receive buffer is full.\n");
+		close_ws(ws, HTTP_WS_CLOSE_TOO_BIG);
+		http_sched_run();
+		return(true);
+	}
+	os_memcpy(ws->in + ws->received, data, size);
+	ws->received += size;
+	
+	//Handle all whole frames.
+	pos = 0;
+	while ((!ws->closing) &&
+		   (used = handle_frame(ws, ws->in + pos, ws->received - pos)))
+	{
+		pos += used;
+	}
+	if (ws->closing)
+	{
+		ws->received = 0;
+	}
+	else if (pos)
+	{
+		os_memmove(ws->in, ws->in + pos, ws->received - pos);
+		ws->received -= pos;
+	}
+	http_sched_run();
+	return(true);
+}
+
+/**
+ * @brief Send a text message.
+ * 
+ * The message is sent, when the connection gets its turn in the
+ * scheduler.
+ * 
+ * @param ws The connection.
+ * @param data The message.
+ * @param size Size of the message.
+ * @return True if the message has been buffered.
+ */
+bool http_ws_send(struct http_ws *ws, const char *data, size_t size)
+{
+	debug("WebSocket %p sending: %.*s.\n", ws->request, size, data);
+	return(queue_frame(ws, HTTP_WS_TEXT, data, size));
+}
+
+/**
+ * @brief Send a text message to all subscribed connections.
+ * 
+ * @param data The message.
+ * @param size Size of the message.
+ */
+void http_ws_broadcast(const char *data, size_t size)
+{
+	unsigned char i;
+
+	if (!n_connections)
+	{
+		return;
+	}
+	for (i = 0; i < HTTP_WS_CONNECTIONS; i++)
+	{
+		if ((connections[i].request) && (connections[i].subscribed))
+		{
+			http_ws_send(&connections[i], data, size);
+		}
+	}
+	http_sched_run();
+}
+
+/**
+ * @brief Forget the WebSocket connection of a request.
+ *
+ * Called when the connection is gone.
+ *
+ * @param request The request.
+ * @return True if the request was a WebSocket, and the caller must free it.
+ */
+bool http_ws_remove(struct http_request *request)
+{
+	struct http_ws *ws;
+
+	if (!request)
+	{
+		return(false);
+	}
+	ws = find(request);
+	if (!ws)
+	{
+		return(false);
+	}
+	debug("WebSocket %p closed.\n", request);
+	ws->request = NULL;
+	ws->pending = 0;
+	ws->received = 0;
+	if (!--n_connections)
+	{
+		os_timer_disarm(&ping_timer);
+	}
+	return(true);
+}
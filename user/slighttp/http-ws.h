@@ -0,0 +1,118 @@
+/** @file http-ws.h
+ *
+ * @brief WebSocket connections.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#ifndef HTTP_WS_H
+#define HTTP_WS_H
+
+#include "c_types.h"
+#include "http.h"
+
+#ifndef HTTP_WS_CONNECTIONS
+/**
+ * @brief Maximum number of open WebSocket connections.
+ */
+#define HTTP_WS_CONNECTIONS 2
+#endif
+
+#ifndef HTTP_WS_BUFFER_SIZE
+/**
+ * @brief Size of the receive and the send buffer of each connection.
+ * 
+ * Larger frames are refused.
+ */
+#define HTTP_WS_BUFFER_SIZE 128
+#endif
+
+#ifndef HTTP_WS_PING
+/**
+ * @brief Time in ms between pings sent to the clients.
+ *
+ * Must be less than #HTTP_TIMEOUT_STREAM.
+ */
+#define HTTP_WS_PING 20000
+#endif
+
+struct http_ws;
+
+/**
+ * @brief Called with each message received.
+ * 
+ * @param ws The connection.
+ * @param data The message, zero terminated.
+ * @param size Size of the message.
+ */
+typedef void (*http_ws_callback)(struct http_ws *ws, char *data, size_t size);
+
+/**
+ * @brief An open WebSocket connection.
+ */
+struct http_ws
+{
+	/**
+	 * @brief The request that was upgraded, NULL if the slot is free.
+	 */
+	struct http_request *request;
+	/**
+	 * @brief Callback for received messages.
+	 */
+	http_ws_callback message;
+	/**
+	 * @brief Wants the messages sent by #http_ws_broadcast.
+	 */
+	bool subscribed;
+	/**
+	 * @brief A close frame has been sent, nothing more is sent.
+	 */
+	bool closing;
+	/**
+	 * @brief Bytes waiting in #in.
+	 */
+	size_t received;
+	/**
+	 * @brief Bytes waiting in #out.
+	 */
+	size_t pending;
+	/**
+	 * @brief Received data, that is not a whole frame yet.
+	 * 
+	 * One byte extra for zero terminating the last message.
+	 */
+	unsigned char in[HTTP_WS_BUFFER_SIZE + 1];
+	/**
+	 * @brief Frames waiting to be sent.
+	 */
+	unsigned char out[HTTP_WS_BUFFER_SIZE];
+};
+
+extern unsigned long http_ws_dropped;
+
+extern void http_ws_init(void);
+extern signed int http_ws_upgrade(struct http_request *request,
+								  http_ws_callback callback);
+extern bool http_ws_recv(struct http_request *request, char *data,
+						 size_t size);
+extern bool http_ws_send(struct http_ws *ws, const char *data, size_t size);
+extern void http_ws_broadcast(const char *data, size_t size);
+extern bool http_ws_remove(struct http_request *request);
+
+#endif //HTTP_WS_H
@@ -57,8 +57,11 @@
 #include "http-common.h"
 #include "http-tcp.h"
 #include "http-handler.h"
+#include "http-log.h"
+#include "http-sse.h"
+#include "http-ws.h"
+#include "http-admit.h"
 #include "http.h"
-#include "tools/ring.h"
 
 /**
  * @brief Server status.
@@ -77,6 +80,10 @@ static bool status = false;
 bool init_http(unsigned int port)
 {
 	debug("Initialising HTTP server on port %d.\n", port);
+	http_log_init();
+	http_sse_init();
+	http_ws_init();
+	http_admit_init();
     //Initialise TCP and listen on port 80.
     if (!init_tcp())
     {
@@ -87,10 +94,6 @@ bool init_http(unsigned int port)
 	{
 		return(false);
 	}
-	//Create buffer for 50 requests.
-	debug("Creating request buffer.\n");
-	init_ring(&request_buffer, sizeof(struct tcp_connection *), HTTP_REQUEST_BUFFER_SIZE);
-	
 	status = true;
 	return(true);
 }
@@ -25,6 +25,8 @@
 #define HTTP_H
 
 #include "net/tcp.h"
+#include "fs/fs.h"
+#include "tools/arena.h"
 /**
  * @brief Server name.
  */
@@ -45,13 +47,79 @@
  * @brief Size of send buffer.
  */
 #define HTTP_SEND_BUFFER_SIZE 1440
+#ifndef HTTP_SEND_BUFFERS
 /**
- * @brief Number of request that can be buffered.
+ * @brief Number of send buffers shared by all responses.
+ * 
+ * This is also the number of responses producing output at the same time.
+ */
+#define HTTP_SEND_BUFFERS 3
+#endif
+/**
+ * @brief Size of the chunks of the request arena.
+ */
+#define HTTP_ARENA_SIZE 512
+#ifndef HTTP_TIMEOUT_HEADERS
+/**
+ * @brief Time in ms to receive the request headers.
+ */
+#define HTTP_TIMEOUT_HEADERS 5000
+#endif
+#ifndef HTTP_TIMEOUT_BODY
+/**
+ * @brief Time in ms allowed between the segments of a message body.
+ */
+#define HTTP_TIMEOUT_BODY 10000
+#endif
+#ifndef HTTP_TIMEOUT_SEND
+/**
+ * @brief Time in ms allowed between the sent call backs of a response.
+ */
+#define HTTP_TIMEOUT_SEND 10000
+#endif
+#ifndef HTTP_TIMEOUT_IDLE
+/**
+ * @brief Time in ms to wait for the client to close, after the response.
+ */
+#define HTTP_TIMEOUT_IDLE 2000
+#endif
+#ifndef HTTP_TIMEOUT_STREAM
+/**
+ * @brief Time in ms an event stream or WebSocket may be quiet.
+ * 
+ * Must be longer than the keep alive times of the streams.
+ */
+#define HTTP_TIMEOUT_STREAM 60000
+#endif
+#ifndef HTTP_BODY_MAX
+/**
+ * @brief Largest message body collected in `request->message`.
+ * 
+ * Larger bodies need a route with a body callback.
+ */
+#define HTTP_BODY_MAX 1024
+#endif
+#ifndef HTTP_ROUTES_MAX
+/**
+ * @brief Largest number of routes in use in one mode.
+ *
+ * Routes above this are left out of the route index. At most 254, and
+ * the route table of all modes can have at most 256 routes.
+ */
+#define HTTP_ROUTES_MAX 48
+#endif
+/**
+ * @brief Number of referenced segments in the send buffer.
  */
-#define HTTP_REQUEST_BUFFER_SIZE 50
+#define HTTP_SEND_SEGMENTS 8
+/**
+ * @brief Referenced data smaller than this is copied right away.
+ */
+#define HTTP_SEGMENT_MIN_SIZE 32
 
-//Forward declaration.
+//Forward declarations.
 struct http_request;
+struct http_route;
 
 /**
  * @brief HTTP request types.
@@ -72,6 +140,19 @@ enum request_types
     HTTP_CONNECT
 };
 
+/**
+ * @brief Bit in a method mask, for a request type.
+ */
+#define HTTP_METHOD(TYPE) (1 << (TYPE))
+/**
+ * @brief Method mask for handlers of GET and HEAD requests.
+ */
+#define HTTP_METHODS_GET (HTTP_METHOD(HTTP_GET) | HTTP_METHOD(HTTP_HEAD))
+/**
+ * @brief Method mask for handlers of any request.
+ */
+#define HTTP_METHODS_ALL 0xffff
+
 /**
  * @brief HTTP response states.
  * 
@@ -109,6 +190,91 @@ enum response_states
     HTTP_STATE_ERROR 
 };
 
+/**
+ * @brief Points in the life of a request that are timestamped.
+ */
+enum http_phases
+{
+	/**
+	 * @brief Connection made.
+	 */
+	HTTP_PHASE_CONNECT,
+	/**
+	 * @brief First data received.
+	 */
+	HTTP_PHASE_RECV,
+	/**
+	 * @brief Request parsed.
+	 */
+	HTTP_PHASE_PARSED,
+	/**
+	 * @brief First handler selected.
+	 */
+	HTTP_PHASE_ROUTED,
+	/**
+	 * @brief First data queued for sending.
+	 */
+	HTTP_PHASE_QUEUED,
+	/**
+	 * @brief Latest sent callback.
+	 */
+	HTTP_PHASE_SENT,
+	/**
+	 * @brief Response done.
+	 */
+	HTTP_PHASE_CLOSE,
+	/**
+	 * @brief Number of phases.
+	 */
+	HTTP_N_PHASES
+};
+
+/**
+ * @brief Types of data referenced from the send buffer.
+ */
+enum http_segment_types
+{
+	/**
+	 * @brief Data in RAM.
+	 */
+	HTTP_SEGMENT_RAM,
+	/**
+	 * @brief Data in memory mapped flash, needing aligned reads.
+	 */
+	HTTP_SEGMENT_FLASH,
+	/**
+	 * @brief Data read from a file.
+	 */
+	HTTP_SEGMENT_FILE
+};
+
+/**
+ * @brief Data that is copied into the send buffer when sending.
+ */
+struct http_segment
+{
+	/**
+	 * @brief Type of the data, see #http_segment_types.
+	 */
+	unsigned char type;
+	/**
+	 * @brief Place reserved in the send buffer.
+	 */
+	char *pos;
+	/**
+	 * @brief Size of the data.
+	 */
+	size_t size;
+	/**
+	 * @brief Pointer to the data.
+	 */
+	const char *data;
+	/**
+	 * @brief File to read the data from.
+	 */
+	FS_FILE_H file;
+};
+
 /**
  * @brief Callback function for HTTP handlers.
  * 
@@ -125,6 +291,21 @@ enum response_states
  */
 typedef signed int (*http_handler_callback)(struct http_request *request);
 
+/**
+ * @brief Callback receiving the message body of a request in chunks.
+ * 
+ * Called as the data arrives, before the handler is called to respond.
+ * Call #http_request_hold to pause the client, if the data can not be
+ * handled right away.
+ * 
+ * @param request The request.
+ * @param data The data, only valid during the call.
+ * @param size Size of the data.
+ * @return False on errors, the rest of the body is then discarded.
+ */
+typedef bool (*http_body_callback)(struct http_request *request, char *data,
+								   size_t size);
+
 /**
  * @brief Structure to keep the data of a HTTP response.
  */
@@ -142,18 +323,40 @@ struct http_response
       * @brief Function pointers to handlers.
       */
      http_handler_callback handler;
+     /**
+      * @brief The route of the current handler.
+      * 
+      * Used to find the next handler, when the current is done.
+      */
+     const struct http_route *route;
+     /**
+      * @brief Methods allowed by routes that were skipped for this request.
+      * 
+      * Send in the `Allow` header of a 405 response.
+      */
+     unsigned short allow;
      /**
       * @brief Pointer to the context used by the sender.
       */
      void *context;
      /**
       * @brief Buffer with TCP data waiting to be send.
+      * 
+      * Taken from the send buffer pool while producing output, else NULL.
       */
-     char send_buffer[HTTP_SEND_BUFFER_SIZE];
+     char *send_buffer;
      /**
       * @brief Pointer to the current position in the send buffer.
       */
      char *send_buffer_pos;
+     /**
+      * @brief Data referenced from the send buffer.
+      */
+     struct http_segment segments[HTTP_SEND_SEGMENTS];
+     /**
+      * @brief Number of referenced segments.
+      */
+     unsigned char n_segments;
      /**
       * @brief Number of recursion levels in response handler.
       */
@@ -195,12 +398,50 @@ struct http_request
     char *headers;
     /**
      * @brief The message body of the HTTP request.
+     * 
+     * NULL if the body is passed to a body callback.
      */
     char *message;
+    /**
+     * @brief Size of the message body.
+     */
+    size_t content_length;
+    /**
+     * @brief Bytes of the message body received so far.
+     */
+    size_t body_received;
     /**
      * @brief Response data for the request.
      */
     struct http_response response;
+    /**
+     * @brief Memory that lives as long as the request.
+     */
+    struct arena arena;
+    /**
+     * @brief Priority class of the response, see #http_sched_classes.
+     */
+    unsigned char sched_class;
+    /**
+     * @brief Is the response waiting for its turn.
+     */
+    bool sched_queued;
+    /**
+     * @brief Is the response waiting for its data to be sent.
+     */
+    bool sched_sending;
+    /**
+     * @brief Time when the response started waiting for its turn.
+     */
+    uint32 sched_time;
+    /**
+     * @brief Next response waiting in the same class.
+     */
+    struct http_request *sched_next;
+    /**
+     * @brief Time of each phase of the request, see #http_phases.
+     */
+    uint32 phase_time[HTTP_N_PHASES];
 };
 
 extern char *http_fs_doc_root;
@@ -208,5 +449,11 @@ extern char *http_fs_doc_root;
 extern bool init_http(unsigned int port);
 extern bool http_get_status(void);
 extern size_t http_send(struct tcp_connection *connection, char *data, size_t size);
+extern size_t http_send_ref(struct tcp_connection *connection,
+							const char *data, size_t size);
+extern size_t http_send_flash(struct tcp_connection *connection,
+							  const char *data, size_t size);
+extern size_t http_send_file(struct tcp_connection *connection,
+							 FS_FILE_H file, size_t size);
 
 #endif
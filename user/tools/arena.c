@@ -0,0 +1,118 @@
+/** @file arena.c
+ *
+ * @brief Bump pointer allocator.
+ * 
+ * Allocations are taken from the current chunk, by moving a pointer
+ * forward. When a chunk is full, a new one is allocated from the heap.
+ * Nothing is freed until everything is freed by #arena_free.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */ 
+#include "c_types.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "arena.h"
+
+/**
+ * @brief Alignment of allocations.
+ */
+#define ARENA_ALIGN 4
+
+/**
+ * @brief Initialise an arena.
+ * 
+ * No memory is allocated until the first call to #arena_alloc.
+ * 
+ * @param arena Pointer to the arena.
+ * @param chunk_size Size of the chunks to allocate from the heap.
+ */
+void arena_init(struct arena *arena, size_t chunk_size)
+{
+	arena->chunks = NULL;
+	arena->chunk_size = chunk_size;
+}
+
+/**
+ * @brief Allocate memory from an arena.
+ * 
+ * @param arena Pointer to the arena.
+ * @param size Bytes to allocate.
+ * @return Pointer to the memory, or NULL if the heap is exhausted.
+ */
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_chunk *chunk = arena->chunks;
+	size_t chunk_size = arena->chunk_size;
+	void *ret;
+	
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	if ((!chunk) || ((chunk->size - chunk->used) < size))
+	{
+		//Big allocations get a chunk of their own.
+		if (size > chunk_size)
+		{
+			chunk_size = size;
+		}
+		debug("New arena chunk of %d bytes for %p.\n", chunk_size, arena);
+		chunk = db_malloc(sizeof(struct arena_chunk) + chunk_size,
+						  "chunk arena_alloc");
+		if (!chunk)
+		{
+			error("Could not allocate arena chunk.\n");
+			return(NULL);
+		}
+		chunk->size = chunk_size;
+		chunk->used = 0;
+		if ((arena->chunks) && (chunk_size > arena->chunk_size))
+		{
+			//Keep using the free space in the current chunk.
+			chunk->next = arena->chunks->next;
+			arena->chunks->next = chunk;
+		}
+		else
+		{
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+		}
+	}
+	ret = (char *)(chunk + 1) + chunk->used;
+	chunk->used += size;
+	return(ret);
+}
+
+/**
+ * @brief Free all memory allocated from an arena.
+ * 
+ * The arena can be used again afterwards.
+ * 
+ * @param arena Pointer to the arena.
+ */
+void arena_free(struct arena *arena)
+{
+	struct arena_chunk *chunk;
+	
+	while (arena->chunks)
+	{
+		chunk = arena->chunks;
+		arena->chunks = chunk->next;
+		db_free(chunk);
+	}
+}
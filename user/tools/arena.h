@@ -0,0 +1,69 @@
+/** @file arena.h
+ *
+ * @brief Bump pointer allocator.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */ 
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "c_types.h"
+
+/**
+ * @brief A block of memory that allocations are taken from.
+ * 
+ * The memory for the allocations follows right after this header.
+ */
+struct arena_chunk
+{
+	/**
+	 * @brief The chunk that was used before this one.
+	 */
+	struct arena_chunk *next;
+	/**
+	 * @brief Bytes of memory in the chunk.
+	 */
+	size_t size;
+	/**
+	 * @brief Bytes used.
+	 */
+	size_t used;
+};
+
+/**
+ * @brief Memory allocations that are freed all at once.
+ */
+struct arena
+{
+	/**
+	 * @brief The chunk currently used, NULL until the first allocation.
+	 */
+	struct arena_chunk *chunks;
+	/**
+	 * @brief Size of new chunks.
+	 */
+	size_t chunk_size;
+};
+
+extern void arena_init(struct arena *arena, size_t chunk_size);
+extern void *arena_alloc(struct arena *arena, size_t size);
+extern void arena_free(struct arena *arena);
+
+#endif
@@ -0,0 +1,71 @@
+/** @file base64.c
+ *
+ * @brief Base64 encoding.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "tools/base64.h"
+
+/**
+ * @brief The Base64 alphabet.
+ */
+static const char base64_chars[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * @brief Base64 encode some data.
+ * 
+ * @param data The data to encode.
+ * @param size Size of the data.
+ * @param result Room for #BASE64_SIZE(size) + 1 characters.
+ * @return Length of the zero terminated result.
+ */
+size_t base64_encode(const unsigned char *data, size_t size, char *result)
+{
+	char *pos = result;
+	uint32 value;
+	
+	while (size >= 3)
+	{
+		value = (data[0] << 16) | (data[1] << 8) | data[2];
+		*pos++ = base64_chars[(value >> 18) & 0x3F];
+		*pos++ = base64_chars[(value >> 12) & 0x3F];
+		*pos++ = base64_chars[(value >> 6) & 0x3F];
+		*pos++ = base64_chars[value & 0x3F];
+		data += 3;
+		size -= 3;
+	}
+	//Pad the last group.
+	if (size)
+	{
+		value = data[0] << 16;
+		if (size > 1)
+		{
+			value |= data[1] << 8;
+		}
+		*pos++ = base64_chars[(value >> 18) & 0x3F];
+		*pos++ = base64_chars[(value >> 12) & 0x3F];
+		*pos++ = (size > 1) ? base64_chars[(value >> 6) & 0x3F] : '=';
+		*pos++ = '=';
+	}
+	*pos = '\0';
+	return(pos - result);
+}
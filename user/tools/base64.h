@@ -1,7 +1,7 @@
-/** @file net.h
- *
- * @brief General network related interface.
+/** @file base64.h
  *
+ * @brief Base64 encoding.
+ * 
  * @copyright
  * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
  * 
@@ -20,12 +20,18 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  * MA 02110-1301, USA.
- */ 
-#ifndef HTTP_NET_H
-#define HTTP_NET_H
+ */
+#ifndef BASE64_H
+#define BASE64_H
+
+#include "c_types.h"
 
-#include "os_type.h"
+/**
+ * @brief Size of the Base64 encoding of SIZE bytes, without the zero byte.
+ */
+#define BASE64_SIZE(SIZE) ((((SIZE) + 2) / 3) * 4)
 
-extern bool net_sending;
+extern size_t base64_encode(const unsigned char *data, size_t size,
+							char *result);
 
-#endif
+#endif //BASE64_H
@@ -9,6 +9,7 @@
  */
 #include "user_config.h" 
 #include "c_types.h"
+#include "osapi.h"
 
 /**
  * @brief Convert an integer to a string.
@@ -78,3 +79,32 @@ char *itoa(long value, char *result, const unsigned char base)
 
 	return(result);
 }
+
+/**
+ * @brief Convert an unsigned integer to a decimal string.
+ * 
+ * Digits are written from the back of a small buffer, so no reversing
+ * or division by a variable base is needed.
+ * 
+ * @param value The value to be converted.
+ * @param result A pointer to where the string is written, must have
+ *               room for 11 characters.
+ * @return Number of digits written, not counting the zero byte.
+ */
+size_t utoa(unsigned long value, char *result)
+{
+	char digits[10];
+	char *ptr = digits + sizeof(digits);
+	size_t size;
+	
+	do
+	{
+		*--ptr = '0' + (value % 10);
+		value /= 10;
+	} while (value);
+	size = digits + sizeof(digits) - ptr;
+	os_memcpy(result, ptr, size);
+	result[size] = '\0';
+	
+	return(size);
+}
@@ -1 +0,0 @@
-../../3rdparty/jsmn/jsmn.c
\ No newline at end of file
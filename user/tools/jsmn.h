@@ -1 +0,0 @@
-../../3rdparty/jsmn/jsmn.h
\ No newline at end of file
@@ -0,0 +1,626 @@
+/**
+ * @file json-decode.c
+ *
+ * @brief Decode a JSON object into fields described by a table.
+ * 
+ * The request body is read once from start to end. Member names are
+ * matched against a table of fields, and values are copied straight to
+ * where the table says, unescaping strings on the way. Nothing is
+ * allocated, and no tokens are stored, so any object can be decoded
+ * using the same small amount of stack. Members not in the table are
+ * skipped, values that are too large, or of the wrong type, makes the
+ * whole object invalid. The elements of an array can be walked one at a
+ * time, to decode each of them.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include <limits.h>
+#include "c_types.h"
+#include "osapi.h"
+#include "user_config.h"
+#include "tools/json-decode.h"
+
+/**
+ * @brief Position in the JSON being decoded.
+ */
+struct json_cursor
+{
+	/**
+	 * @brief Next character.
+	 */
+	const char *pos;
+	/**
+	 * @brief One past the last character.
+	 */
+	const char *end;
+};
+
+/**
+ * @brief Check if there are characters left.
+ * 
+ * A zero byte also ends the JSON.
+ */
+#define MORE(c) (((c)->pos < (c)->end) && (*(c)->pos))
+
+/**
+ * @brief Skip white space.
+ * 
+ * @param c The cursor.
+ */
+static void skip_space(struct json_cursor *c)
+{
+	while (MORE(c) && ((*c->pos == ' ') || (*c->pos == '\t') ||
+					   (*c->pos == '\r') || (*c->pos == '\n')))
+	{
+		c->pos++;
+	}
+}
+
+/**
+ * @brief Skip white space, and an expected character.
+ * 
+ * @param c The cursor.
+ * @param chr The character.
+ * @return True if the character was there.
+ */
+static bool expect(struct json_cursor *c, char chr)
+{
+	skip_space(c);
+	if ((!MORE(c)) || (*c->pos != chr))
+	{
+		return(false);
+	}
+	c->pos++;
+	return(true);
+}
+
+/**
+ * @brief Get the value of a hexadecimal digit.
+ * 
+ * @param chr The digit.
+ * @return The value, or -1 if not a hexadecimal digit.
+ */
+static signed char hex(char chr)
+{
+	if ((chr >= '0') && (chr <= '9'))
+	{
+		return(chr - '0');
+	}
+	if ((chr >= 'a') && (chr <= 'f'))
+	{
+		return(chr - 'a' + 10);
+	}
+	if ((chr >= 'A') && (chr <= 'F'))
+	{
+		return(chr - 'A' + 10);
+	}
+	return(-1);
+}
+
+/**
+ * @brief Read the four digits of a \\u escape, and write it as UTF-8.
+ * 
+ * Surrogate pairs are not supported.
+ * 
+ * @param c The cursor, just after the u.
+ * @param utf8 Room for 3 bytes of UTF-8.
+ * @return Number of bytes of UTF-8, or 0 on error.
+ */
+static unsigned char read_unicode(struct json_cursor *c, char *utf8)
+{
+	unsigned int code = 0;
+	signed char digit;
+	unsigned char i;
+	
+	for (i = 0; i < 4; i++)
+	{
+		if ((!MORE(c)) || ((digit = hex(*c->pos++)) < 0))
+		{
+			return(0);
+		}
+		code = (code << 4) | digit;
+	}
+	if (code < 0x80)
+	{
+		utf8[0] = code;
+		return(1);
+	}
+	if (code < 0x800)
+	{
+		utf8[0] = 0xc0 | (code >> 6);
+		utf8[1] = 0x80 | (code & 0x3f);
+		return(2);
+	}
+	if ((code >= 0xd800) && (code <= 0xdfff))
+	{
+		return(0);
+	}
+	utf8[0] = 0xe0 | (code >> 12);
+	utf8[1] = 0x80 | ((code >> 6) & 0x3f);
+	utf8[2] = 0x80 | (code & 0x3f);
+	return(3);
+}
+
+/**
+ * @brief Read a string, and unescape it into a buffer.
+ * 
+ * As much as there is room for is stored, and the buffer is zero
+ * terminated.
+ * 
+ * @param c The cursor, at the opening double quote.
+ * @param buffer The buffer, or NULL to skip the string.
+ * @param size Size of the buffer.
+ * @return Size of the unescaped string, or -1 if malformed.
+ */
+static signed int read_string(struct json_cursor *c, char *buffer,
+							  size_t size)
+{
+	size_t pos = 0;
+	char chr[3];
+	unsigned char n;
+	
+	if (!expect(c, '\"'))
+	{
+		return(-1);
+	}
+	while (MORE(c) && (*c->pos != '\"'))
+	{
+		chr[0] = *c->pos++;
+		n = 1;
+		if ((unsigned char)chr[0] < 0x20)
+		{
+			return(-1);
+		}
+		if (chr[0] == '\\')
+		{
+			if (!MORE(c))
+			{
+				return(-1);
+			}
+			chr[0] = *c->pos++;
+			switch (chr[0])
+			{
+				case '\"':
+				case '\\':
+				case '/':
+					break;
+				case 'b':
+					chr[0] = '\b';
+					break;
+				case 'f':
+					chr[0] = '\f';
+					break;
+				case 'n':
+					chr[0] = '\n';
+					break;
+				case 'r':
+					chr[0] = '\r';
+					break;
+				case 't':
+					chr[0] = '\t';
+					break;
+				case 'u':
+					n = read_unicode(c, chr);
+					if (!n)
+					{
+						return(-1);
+					}
+					break;
+				default:
+					return(-1);
+			}
+		}
+		if ((buffer) && ((pos + n) < size))
+		{
+			os_memcpy(buffer + pos, chr, n);
+			buffer[pos + n] = '\0';
+		}
+		pos += n;
+	}
+	if (!MORE(c))
+	{
+		return(-1);
+	}
+	//Skip the closing double quote.
+	c->pos++;
+	if ((buffer) && (size) && (!pos))
+	{
+		*buffer = '\0';
+	}
+	return(pos);
+}
+
+/**
+ * @brief Read an integer.
+ * 
+ * @param c The cursor.
+ * @param value Where to put the value.
+ * @return True on success, false if not an integer or out of range.
+ */
+static bool read_number(struct json_cursor *c, signed long *value)
+{
+	bool negative = false;
+	unsigned long n = 0;
+	unsigned long max = LONG_MAX;
+	
+	skip_space(c);
+	if (MORE(c) && (*c->pos == '-'))
+	{
+		negative = true;
+		max++;
+		c->pos++;
+	}
+	if ((!MORE(c)) || (*c->pos < '0') || (*c->pos > '9'))
+	{
+		return(false);
+	}
+	while (MORE(c) && (*c->pos >= '0') && (*c->pos <= '9'))
+	{
+		if (n > ((max - (*c->pos - '0')) / 10))
+		{
+			return(false);
+		}
+		n = n * 10 + (*c->pos++ - '0');
+	}
+	if (MORE(c) && ((*c->pos == '.') || (*c->pos == 'e') ||
+					(*c->pos == 'E')))
+	{
+		return(false);
+	}
+	if (negative)
+	{
+		*value = -(signed long)(n - 1) - 1;
+	}
+	else
+	{
+		*value = n;
+	}
+	return(true);
+}
+
+/**
+ * @brief Read a literal, like true.
+ * 
+ * @param c The cursor.
+ * @param literal The literal.
+ * @return True if the literal was there.
+ */
+static bool read_literal(struct json_cursor *c, const char *literal)
+{
+	size_t size = os_strlen(literal);
+	
+	skip_space(c);
+	if (((size_t)(c->end - c->pos) < size) ||
+		(os_strncmp(c->pos, literal, size) != 0))
+	{
+		return(false);
+	}
+	c->pos += size;
+	return(true);
+}
+
+/**
+ * @brief Check if a character can be part of a number or a literal.
+ * 
+ * @param chr The character.
+ * @return True if it can.
+ */
+static bool primitive(char chr)
+{
+	return(((chr >= '0') && (chr <= '9')) || ((chr >= 'a') && (chr <= 'z')) ||
+		   (chr == '-') || (chr == '+') || (chr == '.') || (chr == 'E'));
+}
+
+/**
+ * @brief Skip a value of any type.
+ * 
+ * Objects and arrays are skipped by counting brackets, without checking
+ * their contents.
+ * 
+ * @param c The cursor.
+ * @return True on success, false if malformed.
+ */
+static bool skip_value(struct json_cursor *c)
+{
+	unsigned int depth = 0;
+	
+	do
+	{
+		skip_space(c);
+		if (!MORE(c))
+		{
+			return(false);
+		}
+		switch (*c->pos)
+		{
+			case '\"':
+				if (read_string(c, NULL, 0) < 0)
+				{
+					return(false);
+				}
+				break;
+			case '{':
+			case '[':
+				depth++;
+				c->pos++;
+				break;
+			case '}':
+			case ']':
+				if (!depth)
+				{
+					return(false);
+				}
+				depth--;
+				c->pos++;
+				break;
+			case ':':
+			case ',':
+				if (!depth)
+				{
+					return(false);
+				}
+				c->pos++;
+				break;
+			default:
+				//Numbers, true, false, and null.
+				if (!primitive(*c->pos))
+				{
+					return(false);
+				}
+				while (MORE(c) && (primitive(*c->pos)))
+				{
+					c->pos++;
+				}
+		}
+	} while (depth);
+	return(true);
+}
+
+/**
+ * @brief Read a value into a field.
+ * 
+ * @param c The cursor.
+ * @param field The field.
+ * @return True on success.
+ */
+static bool read_field(struct json_cursor *c, const struct json_field *field)
+{
+	const char *start;
+	signed int size;
+	
+	switch (field->type)
+	{
+		case JSON_FIELD_STRING:
+			skip_space(c);
+			size = read_string(c, field->value, field->size);
+			if ((size < 0) || ((size_t)size >= field->size))
+			{
+				warn("JSON value of %s is too large, or malformed.\n",
+					 field->name);
+				return(false);
+			}
+			return(true);
+		case JSON_FIELD_NUMBER:
+			return(read_number(c, field->value));
+		case JSON_FIELD_BOOL:
+			if (read_literal(c, "true"))
+			{
+				*((bool *)field->value) = true;
+				return(true);
+			}
+			if (read_literal(c, "false"))
+			{
+				*((bool *)field->value) = false;
+				return(true);
+			}
+			return(false);
+		case JSON_FIELD_RAW:
+			skip_space(c);
+			start = c->pos;
+			if ((!skip_value(c)) || ((size_t)(c->pos - start) >= field->size))
+			{
+				warn("JSON value of %s is too large, or malformed.\n",
+					 field->name);
+				return(false);
+			}
+			os_memcpy(field->value, start, c->pos - start);
+			((char *)field->value)[c->pos - start] = '\0';
+			return(true);
+		default:
+			return(false);
+	}
+}
+
+/**
+ * @brief Decode a JSON object.
+ * 
+ * On error, some of the fields may already have been written.
+ * 
+ * @param json The JSON.
+ * @param size Size of the JSON, decoding also stops at a zero byte.
+ * @param fields The fields expected in the object.
+ * @param n_fields Number of fields, at most #JSON_DECODE_MAX_FIELDS.
+ * @return A bit for each field found, bit 0 being the first field, or
+ *         #JSON_DECODE_ERROR.
+ */
+signed int json_decode(const char *json, size_t size,
+					   const struct json_field *fields,
+					   unsigned char n_fields)
+{
+	struct json_cursor c;
+	char key[JSON_DECODE_KEY_SIZE];
+	signed int key_size;
+	signed int found = 0;
+	unsigned char i;
+	
+	debug("Decoding JSON %s.\n", json);
+	if ((!json) || (n_fields > JSON_DECODE_MAX_FIELDS))
+	{
+		return(JSON_DECODE_ERROR);
+	}
+	c.pos = json;
+	c.end = json + size;
+	if (!expect(&c, '{'))
+	{
+		warn("JSON is not an object.\n");
+		return(JSON_DECODE_ERROR);
+	}
+	skip_space(&c);
+	if (MORE(&c) && (*c.pos == '}'))
+	{
+		c.pos++;
+	}
+	else
+	{
+		do
+		{
+			key_size = read_string(&c, key, sizeof(key));
+			if ((key_size < 0) || (!expect(&c, ':')))
+			{
+				warn("Malformed JSON member.\n");
+				return(JSON_DECODE_ERROR);
+			}
+			//Names too long for the buffer are not in the table.
+			i = n_fields;
+			if ((size_t)key_size < sizeof(key))
+			{
+				for (i = 0; i < n_fields; i++)
+				{
+					if (os_strcmp(key, fields[i].name) == 0)
+					{
+						break;
+					}
+				}
+			}
+			if (i < n_fields)
+			{
+				debug(" JSON member %s.\n", key);
+				if (!read_field(&c, &fields[i]))
+				{
+					warn("Wrong JSON value of %s.\n", key);
+					return(JSON_DECODE_ERROR);
+				}
+				found |= 1 << i;
+			}
+			else if (!skip_value(&c))
+			{
+				warn("Malformed JSON value.\n");
+				return(JSON_DECODE_ERROR);
+			}
+		} while (expect(&c, ','));
+		if (!expect(&c, '}'))
+		{
+			warn("Malformed JSON object.\n");
+			return(JSON_DECODE_ERROR);
+		}
+	}
+	skip_space(&c);
+	if (MORE(&c))
+	{
+		warn("Trailing data after JSON object.\n");
+		return(JSON_DECODE_ERROR);
+	}
+	return(found);
+}
+
+/**
+ * @brief Start walking the elements of a JSON array.
+ * 
+ * @param array The position in the array.
+ * @param json The JSON.
+ * @param size Size of the JSON, walking also stops at a zero byte.
+ * @return True if the JSON starts an array.
+ */
+bool json_array_begin(struct json_array *array, const char *json,
+					  size_t size)
+{
+	struct json_cursor c;
+	
+	if (!json)
+	{
+		return(false);
+	}
+	c.pos = json;
+	c.end = json + size;
+	if (!expect(&c, '['))
+	{
+		warn("JSON is not an array.\n");
+		return(false);
+	}
+	array->pos = c.pos;
+	array->end = c.end;
+	array->first = true;
+	return(true);
+}
+
+/**
+ * @brief Find the next element of a JSON array.
+ * 
+ * The element is not decoded, pass it to #json_decode for that.
+ * 
+ * @param array The position in the array.
+ * @param element Set to the first character of the element.
+ * @return Size of the element, 0 after the last element, or
+ *         #JSON_DECODE_ERROR if the array is malformed.
+ */
+signed int json_array_next(struct json_array *array, const char **element)
+{
+	struct json_cursor c;
+	
+	c.pos = array->pos;
+	c.end = array->end;
+	skip_space(&c);
+	if (!MORE(&c))
+	{
+		warn("Malformed JSON array.\n");
+		return(JSON_DECODE_ERROR);
+	}
+	if (*c.pos == ']')
+	{
+		c.pos++;
+		skip_space(&c);
+		if (MORE(&c))
+		{
+			warn("Trailing data after JSON array.\n");
+			return(JSON_DECODE_ERROR);
+		}
+		array->pos = c.pos;
+		return(0);
+	}
+	if (!array->first)
+	{
+		if (*c.pos != ',')
+		{
+			warn("Malformed JSON array.\n");
+			return(JSON_DECODE_ERROR);
+		}
+		c.pos++;
+	}
+	skip_space(&c);
+	*element = c.pos;
+	if (!skip_value(&c))
+	{
+		warn("Malformed JSON value.\n");
+		return(JSON_DECODE_ERROR);
+	}
+	array->pos = c.pos;
+	array->first = false;
+	return(c.pos - *element);
+}
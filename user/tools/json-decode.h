@@ -0,0 +1,125 @@
+/**
+ * @file json-decode.h
+ *
+ * @brief Decode a JSON object into fields described by a table.
+ * 
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#ifndef JSON_DECODE_H
+#define JSON_DECODE_H
+
+#include "c_types.h"
+
+#ifndef JSON_DECODE_KEY_SIZE
+/**
+ * @brief Room for the longest member name, including the zero byte.
+ * 
+ * Longer names can never match a field, and are skipped.
+ */
+#define JSON_DECODE_KEY_SIZE 16
+#endif
+
+/**
+ * @brief Maximum number of fields in a table.
+ */
+#define JSON_DECODE_MAX_FIELDS 31
+
+/**
+ * @brief Returned when the JSON is malformed, or a value does not fit.
+ */
+#define JSON_DECODE_ERROR -1
+
+/**
+ * @brief String value, stored zero terminated in a char buffer.
+ */
+#define JSON_FIELD_STRING 0
+/**
+ * @brief Integer value, stored in a signed long.
+ */
+#define JSON_FIELD_NUMBER 1
+/**
+ * @brief true or false, stored in a bool.
+ */
+#define JSON_FIELD_BOOL 2
+/**
+ * @brief Any value, stored as its JSON text, zero terminated in a char buffer.
+ */
+#define JSON_FIELD_RAW 3
+
+/**
+ * @brief A member expected in the JSON object.
+ */
+struct json_field
+{
+	/**
+	 * @brief Name of the member.
+	 */
+	const char *name;
+	/**
+	 * @brief Type of the value, one of the JSON_FIELD_* values.
+	 */
+	unsigned char type;
+	/**
+	 * @brief Where the value goes.
+	 */
+	void *value;
+	/**
+	 * @brief Size of the buffer of a string, including the zero byte.
+	 */
+	size_t size;
+};
+
+/**
+ * @brief Position in a JSON array, while walking its elements.
+ */
+struct json_array
+{
+	/**
+	 * @brief Next character.
+	 */
+	const char *pos;
+	/**
+	 * @brief One past the last character.
+	 */
+	const char *end;
+	/**
+	 * @brief True until the first element has been read.
+	 */
+	bool first;
+};
+
+/**
+ * @brief Check if a field was in the JSON.
+ * 
+ * @param found Return value of json_decode.
+ * @param i Index of the field in the table.
+ */
+#define JSON_FOUND(found, i) (((found) > 0) && ((found) & (1 << (i))))
+
+extern signed int json_decode(const char *json, size_t size,
+							  const struct json_field *fields,
+							  unsigned char n_fields);
+extern bool json_array_begin(struct json_array *array, const char *json,
+							 size_t size);
+extern signed int json_array_next(struct json_array *array,
+								  const char **element);
+
+#endif //JSON_DECODE_H
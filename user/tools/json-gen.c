@@ -28,6 +28,8 @@
 #include "osapi.h"
 #include "user_interface.h"
 #include "user_config.h"
+#include "tools/strxtra.h"
+#include "tools/json-gen.h"
 
 char *json_create_pair(char *string, char *value, bool quotes)
 {
@@ -101,8 +103,8 @@ char *json_add_to_type(char *json_string, char *element, char *type)
 	{
 		debug("Existing object.\n");
 		size_t old_object_size = strlen(json_string);
-		//Reserve memory add space for ",".
-		object_size = old_object_size + element_size + 1;
+		//Reserve memory add space for "," and \0.
+		object_size = old_object_size + element_size + 2;
 		ret = db_realloc(json_string, object_size,
 						 "json_add_to_object ret");
 		//Point to the ending } of the old object.
@@ -119,3 +121,15 @@ char *json_add_to_type(char *json_string, char *element, char *type)
 
 	return(ret);
 }
+
+char *json_add_number(char *json_string, char *name, unsigned long value)
+{
+	char number[11];
+	char *pair;
+	
+	utoa(value, number);
+	pair = json_create_pair(name, number, false);
+	json_string = json_add_to_object(json_string, pair);
+	db_free(pair);
+	return(json_string);
+}
@@ -67,5 +67,14 @@ extern char *json_create_pair(char *string, char *value, bool quotes);
  * @return Pointer to the string representation of the of the new JSON object.
  */
 extern char *json_add_to_type(char *json_string, char *element, char *type);
+/**
+ * @brief Add a number member to a JSON object.
+ * 
+ * @param json_string Pointer to previous string representation of the object, or NULL to create.
+ * @param name Name of the member.
+ * @param value The value of the member.
+ * @return Pointer to the string representation of the of the new JSON object.
+ */
+extern char *json_add_number(char *json_string, char *name, unsigned long value);
 
 #endif //JSON_GEN_H
@@ -0,0 +1,363 @@
+/**
+ * @file json-writer.c
+ *
+ * @brief Streaming JSON writer.
+ * 
+ * Writes JSON straight into a buffer, without building temporary
+ * strings on the heap. Commas are put in as values are added, and
+ * strings are escaped on the way.
+ * 
+ * With no buffer, the writer only counts the size of the JSON. Running
+ * the same code twice, first to count and then to write, gives a
+ * response in a single allocation of the exact size, and the size for
+ * the Content-Length header.
+ * 
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "user_config.h"
+#include "tools/strxtra.h"
+#include "tools/json-writer.h"
+
+/**
+ * @brief Hexadecimal digits for escaping control characters.
+ */
+static const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief Write data to the buffer.
+ * 
+ * The size is counted even if there is no room, and the buffer is
+ * kept zero terminated.
+ * 
+ * @param writer The writer.
+ * @param data The data to write.
+ * @param size Size of the data.
+ */
+static void put(struct json_writer *writer, const char *data, size_t size)
+{
+	if (writer->buffer)
+	{
+		if ((writer->pos + size) < writer->size)
+		{
+			os_memcpy(writer->buffer + writer->pos, data, size);
+			writer->buffer[writer->pos + size] = '\0';
+		}
+		else
+		{
+			writer->error = true;
+		}
+	}
+	writer->pos += size;
+}
+
+/**
+ * @brief Write a comma if a value is not the first at its level.
+ * 
+ * @param writer The writer.
+ */
+static void separate(struct json_writer *writer)
+{
+	uint32 bit = 1 << writer->depth;
+	
+	if (writer->key)
+	{
+		//The comma went before the key.
+		writer->key = false;
+		return;
+	}
+	if (writer->first & bit)
+	{
+		writer->first &= ~bit;
+	}
+	else if (writer->depth)
+	{
+		put(writer, ",", 1);
+	}
+}
+
+/**
+ * @brief Start an object or array.
+ * 
+ * @param writer The writer.
+ * @param chr The opening character.
+ */
+static void begin(struct json_writer *writer, const char *chr)
+{
+	separate(writer);
+	put(writer, chr, 1);
+	if (writer->depth >= (JSON_WRITER_DEPTH - 1))
+	{
+		warn("JSON nested too deep.\n");
+		writer->error = true;
+		return;
+	}
+	writer->depth++;
+	writer->first |= 1 << writer->depth;
+}
+
+/**
+ * @brief End an object or array.
+ * 
+ * @param writer The writer.
+ * @param chr The closing character.
+ */
+static void end(struct json_writer *writer, const char *chr)
+{
+	if (!writer->depth)
+	{
+		warn("JSON end without a beginning.\n");
+		writer->error = true;
+		return;
+	}
+	writer->first &= ~(1 << writer->depth);
+	writer->depth--;
+	put(writer, chr, 1);
+}
+
+/**
+ * @brief Write an escaped string in double quotes.
+ * 
+ * @param writer The writer.
+ * @param str The string.
+ * @param size Size of the string.
+ */
+static void put_string(struct json_writer *writer, const char *str,
+					   size_t size)
+{
+	char escape[6] = "\\u00";
+	const char *start = str;
+	const char *end = str + size;
+	
+	put(writer, "\"", 1);
+	while (str < end)
+	{
+		if ((*str != '\"') && (*str != '\\') &&
+			((unsigned char)(*str) >= 0x20))
+		{
+			str++;
+			continue;
+		}
+		//Write the plain part so far in one go.
+		put(writer, start, str - start);
+		switch (*str)
+		{
+			case '\"':
+				put(writer, "\\\"", 2);
+				break;
+			case '\\':
+				put(writer, "\\\\", 2);
+				break;
+			case '\n':
+				put(writer, "\\n", 2);
+				break;
+			case '\r':
+				put(writer, "\\r", 2);
+				break;
+			case '\t':
+				put(writer, "\\t", 2);
+				break;
+			default:
+				escape[4] = hex_digits[(unsigned char)(*str) >> 4];
+				escape[5] = hex_digits[*str & 0x0f];
+				put(writer, escape, 6);
+		}
+		start = ++str;
+	}
+	put(writer, start, str - start);
+	put(writer, "\"", 1);
+}
+
+/**
+ * @brief Set up a writer.
+ * 
+ * @param writer The writer.
+ * @param buffer Buffer to write to, or NULL to only count the size.
+ * @param size Size of the buffer, including room for the zero byte.
+ */
+void json_writer_init(struct json_writer *writer, char *buffer, size_t size)
+{
+	writer->buffer = buffer;
+	writer->size = size;
+	writer->pos = 0;
+	writer->first = 1;
+	writer->depth = 0;
+	writer->key = false;
+	writer->error = false;
+	if ((buffer) && (size))
+	{
+		*buffer = '\0';
+	}
+}
+
+/**
+ * @brief Get the size of the JSON.
+ * 
+ * @param writer The writer.
+ * @return Size of the JSON, not counting the zero byte, or 0 if it did
+ *         not fit in the buffer or is not complete.
+ */
+size_t json_writer_size(struct json_writer *writer)
+{
+	if ((writer->error) || (writer->depth) || (writer->key))
+	{
+		return(0);
+	}
+	return(writer->pos);
+}
+
+/**
+ * @brief Start an object.
+ * 
+ * @param writer The writer.
+ */
+void json_begin_object(struct json_writer *writer)
+{
+	begin(writer, "{");
+}
+
+/**
+ * @brief End an object.
+ * 
+ * @param writer The writer.
+ */
+void json_end_object(struct json_writer *writer)
+{
+	end(writer, "}");
+}
+
+/**
+ * @brief Start an array.
+ * 
+ * @param writer The writer.
+ */
+void json_begin_array(struct json_writer *writer)
+{
+	begin(writer, "[");
+}
+
+/**
+ * @brief End an array.
+ * 
+ * @param writer The writer.
+ */
+void json_end_array(struct json_writer *writer)
+{
+	end(writer, "]");
+}
+
+/**
+ * @brief Write the name of an object member.
+ * 
+ * The value must be written next.
+ * 
+ * @param writer The writer.
+ * @param key Name of the member.
+ */
+void json_key(struct json_writer *writer, const char *key)
+{
+	separate(writer);
+	put_string(writer, key, os_strlen(key));
+	put(writer, ":", 1);
+	writer->key = true;
+}
+
+/**
+ * @brief Write a string value.
+ * 
+ * @param writer The writer.
+ * @param str The string, need not be zero terminated.
+ * @param size Size of the string.
+ */
+void json_string(struct json_writer *writer, const char *str, size_t size)
+{
+	separate(writer);
+	put_string(writer, str, size);
+}
+
+/**
+ * @brief Write a number value.
+ * 
+ * @param writer The writer.
+ * @param value The value.
+ */
+void json_number(struct json_writer *writer, unsigned long value)
+{
+	char digits[11];
+	
+	separate(writer);
+	put(writer, digits, utoa(value, digits));
+}
+
+/**
+ * @brief Write a signed number value.
+ * 
+ * @param writer The writer.
+ * @param value The value.
+ */
+void json_signed(struct json_writer *writer, signed long value)
+{
+	char digits[12];
+	
+	separate(writer);
+	if (value < 0)
+	{
+		digits[0] = '-';
+		//Negate without overflowing at the smallest value.
+		put(writer, digits,
+			utoa((unsigned long)(-(value + 1)) + 1, digits + 1) + 1);
+		return;
+	}
+	put(writer, digits, utoa(value, digits));
+}
+
+/**
+ * @brief Write a true or false value.
+ * 
+ * @param writer The writer.
+ * @param value The value.
+ */
+void json_bool(struct json_writer *writer, bool value)
+{
+	separate(writer);
+	if (value)
+	{
+		put(writer, "true", 4);
+	}
+	else
+	{
+		put(writer, "false", 5);
+	}
+}
+
+/**
+ * @brief Write a value that is already JSON.
+ * 
+ * @param writer The writer.
+ * @param json The JSON value.
+ * @param size Size of the JSON value.
+ */
+void json_raw(struct json_writer *writer, const char *json, size_t size)
+{
+	separate(writer);
+	put(writer, json, size);
+}
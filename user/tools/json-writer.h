@@ -0,0 +1,89 @@
+/**
+ * @file json-writer.h
+ *
+ * @brief Streaming JSON writer.
+ * 
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include "c_types.h"
+
+/**
+ * @brief Maximum nesting of objects and arrays.
+ */
+#define JSON_WRITER_DEPTH 32
+
+/**
+ * @brief State of a JSON writer.
+ */
+struct json_writer
+{
+	/**
+	 * @brief Buffer to write to, or NULL to only count the size.
+	 */
+	char *buffer;
+	/**
+	 * @brief Size of the buffer, including room for the zero byte.
+	 */
+	size_t size;
+	/**
+	 * @brief Size of the JSON written so far.
+	 * 
+	 * Keeps counting when the buffer is full.
+	 */
+	size_t pos;
+	/**
+	 * @brief A bit for each level, set when the next value is the first.
+	 */
+	uint32 first;
+	/**
+	 * @brief Current nesting level.
+	 */
+	unsigned char depth;
+	/**
+	 * @brief True when a key has been written, and its value is next.
+	 */
+	bool key;
+	/**
+	 * @brief True if the JSON did not fit in the buffer, or nesting was wrong.
+	 */
+	bool error;
+};
+
+extern void json_writer_init(struct json_writer *writer, char *buffer,
+							 size_t size);
+extern size_t json_writer_size(struct json_writer *writer);
+extern void json_begin_object(struct json_writer *writer);
+extern void json_end_object(struct json_writer *writer);
+extern void json_begin_array(struct json_writer *writer);
+extern void json_end_array(struct json_writer *writer);
+extern void json_key(struct json_writer *writer, const char *key);
+extern void json_string(struct json_writer *writer, const char *str,
+						size_t size);
+extern void json_number(struct json_writer *writer, unsigned long value);
+extern void json_signed(struct json_writer *writer, signed long value);
+extern void json_bool(struct json_writer *writer, bool value);
+extern void json_raw(struct json_writer *writer, const char *json,
+					 size_t size);
+
+#endif //JSON_WRITER_H
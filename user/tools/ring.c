@@ -21,102 +21,162 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  * MA 02110-1301, USA.
  */ 
+#include "c_types.h"
+#include "osapi.h"
 #include "user_interface.h"
 #include "user_config.h"
 #include "ring.h"
 
 /**
- * @brief Initialise and allocate space for a ring buffer.
+ * @brief Keep the compiler from moving memory access across this point.
+ * 
+ * The ESP8266 has a single in order core, so this is enough to make sure
+ * an item is written before the index that publishes it.
+ */
+#define ring_barrier() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * @brief Initialise a ring buffer using storage supplied by the caller.
  * 
  * @param rb Pointer to the ring buffer structure.
- * @param size Size of an entry in the buffer.
- * @param capacity Desired capacity of the buffer.
- * @return
+ * @param storage Memory for the items, at least item_size * capacity bytes.
+ * @param item_size Size of an entry in the buffer.
+ * @param capacity Capacity of the buffer, must be a power of two.
+ * @return True on success, false if capacity is not a power of two.
  */
-void init_ring(struct ring_buffer *rb, size_t size, size_t capacity)
+bool init_ring(struct ring_buffer *rb, void *storage, size_t item_size,
+			   unsigned short capacity)
 {
 	debug("Creating ring buffer at %p.\n", rb);
-	rb->data = db_malloc(size * capacity, "rb->data init_ring");
-	rb->capacity = capacity;
-	rb->count = 0;
-	rb->head = rb->data;
-	rb->tail = rb->data;
-	rb->item_size = size;
-	debug(" Item size: %d.\n", size);
+	if ((!capacity) || (capacity & (capacity - 1)) || (capacity > 0x8000))
+	{
+		error("Ring buffer capacity %d is not a power of two.\n", capacity);
+		return(false);
+	}
+	rb->data = storage;
+	rb->item_size = item_size;
+	rb->mask = capacity - 1;
+	rb->head = 0;
+	rb->tail = 0;
+	debug(" Item size: %d.\n", item_size);
 	debug(" Capacity: %d items.\n", capacity);
-	debug(" Buffer size: %d bytes.\n", size*capacity); 
+	return(true);
 }
 
 /**
- * @brief Get a pointer to a new item at the end of the buffer.
+ * @brief Get a pointer to the free item at the end of the buffer.
  * 
- * @param rb Pointer to a buffer to add the item to.
+ * The item is not part of the buffer until #ring_commit_back is called.
+ * 
+ * @param rb Pointer to the buffer.
+ * @return Pointer to the item, or NULL if the buffer is full.
  */
-void *ring_push_back(struct ring_buffer *rb)
+void *ring_back(struct ring_buffer *rb)
 {
-	void *ret;
-	
-	debug("Getting empty item in ring buffer %p.\n", rb);
-	rb->count++;
-	
-	//Check for overflow.
-	if (rb->count == rb->capacity)
+	if (ring_full(rb))
 	{
-		rb->count--;
-		debug(" Buffer is full.\n");
+		debug(" Ring buffer %p is full.\n", rb);
 		return(NULL);
 	}
+	return((char *)rb->data + (rb->tail & rb->mask) * rb->item_size);
+}
 
-	ret = rb->tail;
-	rb->tail = rb->tail + rb->item_size;
-	//Handle wrap around.
-	if (rb->tail > (rb->data + ((rb->capacity - 1) * rb->item_size)))
+/**
+ * @brief Add the item returned by #ring_back to the buffer.
+ * 
+ * @param rb Pointer to the buffer.
+ */
+void ring_commit_back(struct ring_buffer *rb)
+{
+	ring_barrier();
+	rb->tail++;
+}
+
+/**
+ * @brief Copy an item to the end of the buffer.
+ * 
+ * @param rb Pointer to the buffer.
+ * @param item Pointer to the item.
+ * @return True on success, false if the buffer is full.
+ */
+bool ring_push_back(struct ring_buffer *rb, const void *item)
+{
+	void *slot = ring_back(rb);
+	
+	if (!slot)
 	{
-		debug(" Reached the end of the buffer array.\n");
-		//Go back to the start.
-		rb->tail = rb->data;
+		return(false);
 	}
-	debug(" Got %d of %d items: %p.\n", rb->count, rb->capacity, ret);
-
-	return(ret);
+	os_memcpy(slot, item, rb->item_size);
+	ring_commit_back(rb);
+	return(true);
 }
 
 /**
- * @brief Get a pointer to a copy of the next item in the buffer, and free it.
+ * @brief Get a pointer to the first item in the buffer.
+ * 
+ * The item stays in the buffer until #ring_drop_front is called.
  * 
- * @param rb Pointer to a buffer to get the item from.
+ * @param rb Pointer to the buffer.
+ * @return Pointer to the item, or NULL if the buffer is empty.
  */
-void *ring_pop_front(struct ring_buffer *rb)
+void *ring_peek_front(struct ring_buffer *rb)
 {
-	void *new_head;
-	void *ret;
-	
-	debug("Getting next item in ring buffer %p.\n", rb);
+	if (!ring_count(rb))
+	{
+		return(NULL);
+	}
+	ring_barrier();
+	return((char *)rb->data + (rb->head & rb->mask) * rb->item_size);
+}
 
-	//Check for underflow.
-	if (!rb->count)
+/**
+ * @brief Get a pointer to an item in the buffer, counting from the front.
+ * 
+ * @param rb Pointer to the buffer.
+ * @param n Number of the item, 0 is the first.
+ * @return Pointer to the item, or NULL if there are not that many items.
+ */
+void *ring_peek(struct ring_buffer *rb, unsigned short n)
+{
+	if (n >= ring_count(rb))
 	{
-		debug(" Buffer is empty.\n");
 		return(NULL);
 	}
+	ring_barrier();
+	return((char *)rb->data + ((rb->head + n) & rb->mask) * rb->item_size);
+}
 
-	//Handle wrap around.
-	new_head = rb->head + rb->item_size;
-	if (new_head > (rb->data + ((rb->capacity - 1) * rb->item_size)))
+/**
+ * @brief Remove the first item from the buffer.
+ * 
+ * @param rb Pointer to the buffer.
+ */
+void ring_drop_front(struct ring_buffer *rb)
+{
+	if (ring_count(rb))
 	{
-		debug(" Reached the end of the buffer array.\n");
-		//Go back to the start.
-		new_head = rb->data;
+		ring_barrier();
+		rb->head++;
 	}
+}
 
-	debug(" Got %d of %d items: %p.\n", rb->count, rb->capacity, rb->head);
-	rb->count--;
-	
-	ret = db_malloc(rb->item_size, "ret ring_pop_front");
-	os_memcpy(ret, rb->head, rb->item_size);
-	debug(" Returning copy at %p.\n", ret);
-	//Point head at next item.
-	rb->head = new_head;
+/**
+ * @brief Copy the first item of the buffer to the caller, and remove it.
+ * 
+ * @param rb Pointer to the buffer.
+ * @param item Where to copy the item to.
+ * @return True on success, false if the buffer is empty.
+ */
+bool ring_pop_front(struct ring_buffer *rb, void *item)
+{
+	void *slot = ring_peek_front(rb);
 	
-	return(ret);
+	if (!slot)
+	{
+		return(false);
+	}
+	os_memcpy(item, slot, rb->item_size);
+	ring_drop_front(rb);
+	return(true);
 }
@@ -24,39 +24,60 @@
 #ifndef RING_H
 #define RING_H
 
+#include "c_types.h"
+
 /**
  * @brief Ring buffer structure.
+ * 
+ * The capacity is a power of two, and head and tail are free running
+ * indexes, masked when used. This uses all items of the buffer, and 
+ * the number of items is simply `tail - head`.
+ * 
+ * Only the producer moves the tail, and only the consumer moves the head,
+ * so one producer (for instance an interrupt handler), and one consumer
+ * can use the buffer without locking.
  */
 struct ring_buffer
 {
 	/**
-	 * @brief Pointer to the data in the buffer.
+	 * @brief Pointer to the storage of the items, supplied by the user.
 	 */
 	void *data;
 	/**
-	 * @brief Pointer to the first item of the buffer.
+	 * @brief Size of an item.
+	 */
+	size_t item_size;
+	/**
+	 * @brief Capacity of the buffer minus one.
+	 */
+	unsigned short mask;
+	/**
+	 * @brief Index of the first item, only written by the consumer.
 	 */
-	 void *head;
-	 /**
-	  * @brief Pointer to the last used item in buffer.
-	  */
-	 void *tail;
-	 /**
-	  * @brief Capacity of the buffer.
-	  */
-	 size_t capacity;
-	 /**
-	  * @brief Items in the buffer.
-	  */
-	 size_t count;
-	 /**
-	  * @brief Size of an item.
-	  */
-	 size_t item_size;
+	volatile unsigned short head;
+	/**
+	 * @brief Index after the last item, only written by the producer.
+	 */
+	volatile unsigned short tail;
 };
 
-extern void init_ring(struct ring_buffer *rb, size_t size, size_t capacity);
-extern void *ring_push_back(struct ring_buffer *rb);
-extern void *ring_pop_front(struct ring_buffer *rb);
+/**
+ * @brief Number of items in a ring buffer.
+ */
+#define ring_count(rb) ((unsigned short)((rb)->tail - (rb)->head))
+/**
+ * @brief Is the ring buffer full.
+ */
+#define ring_full(rb) (ring_count(rb) > (rb)->mask)
+
+extern bool init_ring(struct ring_buffer *rb, void *storage,
+					  size_t item_size, unsigned short capacity);
+extern void *ring_back(struct ring_buffer *rb);
+extern void ring_commit_back(struct ring_buffer *rb);
+extern bool ring_push_back(struct ring_buffer *rb, const void *item);
+extern void *ring_peek_front(struct ring_buffer *rb);
+extern void *ring_peek(struct ring_buffer *rb, unsigned short n);
+extern void ring_drop_front(struct ring_buffer *rb);
+extern bool ring_pop_front(struct ring_buffer *rb, void *item);
 
 #endif
@@ -0,0 +1,169 @@
+/** @file sha1.c
+ *
+ * @brief SHA-1 message digest.
+ *
+ * Straight forward implementation of FIPS 180-4, used for the
+ * WebSocket handshake. Favours size over speed.
+ * 
+ * @copyright
+ * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
+ * 
+ * @license
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+#include "c_types.h"
+#include "osapi.h"
+#include "tools/sha1.h"
+
+/**
+ * @brief Rotate a 32 bit value left.
+ */
+#define SHA1_ROL(VALUE, BITS) (((VALUE) << (BITS)) | ((VALUE) >> (32 - (BITS))))
+
+/**
+ * @brief Hash a 64 byte block.
+ * 
+ * @param context The SHA-1 state.
+ */
+static void transform(struct sha1_context *context)
+{
+	uint32 w[16];
+	uint32 a, b, c, d, e, f, k, temp;
+	unsigned char i;
+	
+	for (i = 0; i < 16; i++)
+	{
+		w[i] = ((uint32)context->block[i * 4] << 24) |
+			   ((uint32)context->block[i * 4 + 1] << 16) |
+			   ((uint32)context->block[i * 4 + 2] << 8) |
+			   (uint32)context->block[i * 4 + 3];
+	}
+	a = context->state[0];
+	b = context->state[1];
+	c = context->state[2];
+	d = context->state[3];
+	e = context->state[4];
+	for (i = 0; i < 80; i++)
+	{
+		//Expand the message schedule in place.
+		if (i >= 16)
+		{
+			temp = w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15];
+			w[i & 15] = SHA1_ROL(temp, 1);
+		}
+		if (i < 20)
+		{
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		}
+		else if (i < 40)
+		{
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		}
+		else if (i < 60)
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		temp = SHA1_ROL(a, 5) + f + e + k + w[i & 15];
+		e = d;
+		d = c;
+		c = SHA1_ROL(b, 30);
+		b = a;
+		a = temp;
+	}
+	context->state[0] += a;
+	context->state[1] += b;
+	context->state[2] += c;
+	context->state[3] += d;
+	context->state[4] += e;
+}
+
+/**
+ * @brief Start a new SHA-1 calculation.
+ * 
+ * @param context The SHA-1 state.
+ */
+void sha1_init(struct sha1_context *context)
+{
+	context->state[0] = 0x67452301;
+	context->state[1] = 0xEFCDAB89;
+	context->state[2] = 0x98BADCFE;
+	context->state[3] = 0x10325476;
+	context->state[4] = 0xC3D2E1F0;
+	context->count = 0;
+}
+
+/**
+ * @brief Add data to the SHA-1 calculation.
+ * 
+ * @param context The SHA-1 state.
+ * @param data The data.
+ * @param size Size of the data.
+ */
+void sha1_update(struct sha1_context *context, const void *data, size_t size)
+{
+	const unsigned char *pos = data;
+	
+	while (size--)
+	{
+		context->block[context->count++ & 63] = *pos++;
+		if (!(context->count & 63))
+		{
+			transform(context);
+		}
+	}
+}
+
+/**
+ * @brief End the SHA-1 calculation.
+ * 
+ * @param context The SHA-1 state.
+ * @param digest Room for #SHA1_DIGEST_SIZE bytes of digest.
+ */
+void sha1_final(struct sha1_context *context, unsigned char *digest)
+{
+	uint32 bits = context->count << 3;
+	unsigned char used;
+	unsigned char i;
+	
+	used = context->count & 63;
+	context->block[used++] = 0x80;
+	//Make room for the length.
+	if (used > 56)
+	{
+		os_memset(context->block + used, 0, 64 - used);
+		transform(context);
+		used = 0;
+	}
+	os_memset(context->block + used, 0, 60 - used);
+	//Length in bits, big endian. Messages are way less than 512MB.
+	context->block[60] = bits >> 24;
+	context->block[61] = bits >> 16;
+	context->block[62] = bits >> 8;
+	context->block[63] = bits;
+	transform(context);
+	for (i = 0; i < SHA1_DIGEST_SIZE; i++)
+	{
+		digest[i] = context->state[i >> 2] >> ((3 - (i & 3)) * 8);
+	}
+}
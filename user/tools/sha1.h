@@ -1,7 +1,7 @@
-/** @file net.c
- *
- * @brief General network related variables and functions.
+/** @file sha1.h
  *
+ * @brief SHA-1 message digest.
+ * 
  * @copyright
  * Copyright 2015 Martin Bo Kristensen Grønholdt <oblivion@@ace2>
  * 
@@ -20,7 +20,40 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  * MA 02110-1301, USA.
- */ 
-#include "net/net.h"
+ */
+#ifndef SHA1_H
+#define SHA1_H
+
+#include "c_types.h"
+
+/**
+ * @brief Size of a SHA-1 digest in bytes.
+ */
+#define SHA1_DIGEST_SIZE 20
+
+/**
+ * @brief State of a running SHA-1 calculation.
+ */
+struct sha1_context
+{
+	/**
+	 * @brief Intermediate hash value.
+	 */
+	uint32 state[5];
+	/**
+	 * @brief Number of bytes hashed so far.
+	 */
+	uint32 count;
+	/**
+	 * @brief Data waiting for a full block.
+	 */
+	unsigned char block[64];
+};
+
+extern void sha1_init(struct sha1_context *context);
+extern void sha1_update(struct sha1_context *context, const void *data,
+						size_t size);
+extern void sha1_final(struct sha1_context *context,
+					   unsigned char *digest);
 
-bool net_sending = false;
+#endif //SHA1_H
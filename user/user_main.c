@@ -78,6 +78,7 @@
 #include "handlers/fs//http-fs.h"
 #include "slighttp/http-handler.h"
 #include "handlers/deny/http-deny.h"
+#include "slighttp/http-sse.h"
 
 /**
  * @brief Linker symbol that points to the end of the ROM code in flash.
@@ -104,6 +105,40 @@ os_signal_t signal_reset;
  */
 os_timer_t status_timer;
 
+/* Routes of the web server, in the order they are tried. The normal
+ * and configuration mode routes are selected in #connected. */
+HTTP_METHOD_ROUTE(100, HTTP_ROUTES_ALL, "/rest/fw/mem", &http_rest_mem_methods);
+HTTP_METHOD_ROUTE(110, HTTP_ROUTES_ALL, "/rest/fw/version",
+				  &http_rest_version_methods);
+HTTP_METHOD_ROUTE(120, HTTP_ROUTES_ALL, "/rest/fw/sched",
+				  &http_rest_sched_methods);
+HTTP_METHOD_ROUTE(130, HTTP_ROUTES_ALL, "/rest/fw/latency",
+				  &http_rest_latency_methods);
+HTTP_METHOD_ROUTE(140, HTTP_ROUTES_ALL, "/rest/fw/log", &http_rest_log_methods);
+HTTP_METHOD_ROUTE(150, HTTP_ROUTES_ALL, "/rest/batch", &http_rest_batch_methods);
+//Normal mode.
+HTTP_METHOD_ROUTE(200, HTTP_ROUTES_NORMAL, "/rest/gpios",
+				  &http_rest_gpios_methods);
+HTTP_METHOD_ROUTE(210, HTTP_ROUTES_NORMAL, "/rest/gpios/*",
+				  &http_rest_gpio_methods);
+HTTP_ROUTE(220, HTTP_ROUTES_NORMAL, "/ws/gpio", HTTP_METHODS_GET,
+		   &http_rest_gpio_ws_handler);
+HTTP_ROUTE(230, HTTP_ROUTES_NORMAL, "/rest/events", HTTP_METHODS_GET,
+		   &http_sse_handler);
+HTTP_ROUTE(240, HTTP_ROUTES_NORMAL, "/connect/*", HTTP_METHODS_ALL,
+		   &http_deny_handler);
+//Network configuration mode.
+HTTP_METHOD_ROUTE(300, HTTP_ROUTES_CONFIG, "/rest/net/password",
+				  &http_rest_net_passwd_methods);
+HTTP_ROUTE(310, HTTP_ROUTES_CONFIG, "/rest/net/networks", HTTP_METHODS_GET,
+		   &http_rest_net_names_handler);
+HTTP_METHOD_ROUTE(320, HTTP_ROUTES_CONFIG, "/rest/net/network",
+				  &http_rest_network_methods);
+//File system, and errors.
+HTTP_ROUTE(900, HTTP_ROUTES_ALL, "/*", HTTP_METHODS_GET, &http_fs_handler);
+HTTP_ROUTE(910, HTTP_ROUTES_ALL, "/*", HTTP_METHODS_ALL, &http_fs_error_handler);
+HTTP_ROUTE(920, HTTP_ROUTES_ALL, "/*", HTTP_METHODS_ALL, &http_status_handler);
+
 /**
  * @brief Button handler that activates configuration mode. 
  * 
@@ -144,6 +179,7 @@ static void button_switch(os_param_t gpio)
 		gpio_state = !GPIO_INPUT_GET(5);
 		debug(" New state: %d.\n", gpio_state);
 		GPIO_OUTPUT_SET(5, gpio_state);
+		http_rest_gpio_notify(5);
 	}
 	
 	button_ack(gpio);
@@ -175,26 +211,9 @@ static void connected(os_signal_t mode)
 	if (!config_mode)
 	{
 		//Start web server with default pages.
-		init_http(80);		
-		db_printf("Adding memory REST handler.\n");
-		http_add_handler("/rest/fw/mem", &http_rest_mem_handler);
-		db_printf("Adding version REST handler.\n");
-		http_add_handler("/rest/fw/version", &http_rest_version_handler);
-		/*db_printf("Adding network names REST handler.\n");
-		http_add_handler("/rest/net/networks", &http_rest_net_names_handler);
-		db_printf("Adding default network REST handler.\n");
-		http_add_handler("/rest/net/network", &http_rest_network_handler);*/
-		db_printf("Adding gpio REST handler.\n");
-		http_add_handler("/rest/gpios/*", &http_rest_gpio_handler);
-		db_printf("Adding deny handler.\n");
-		http_add_handler("/connect/*", &http_deny_handler);
+		init_http(80);
 		http_fs_init("/");
-		db_printf("Adding file system handler.\n");
-		http_add_handler("/*", &http_fs_handler);
-		db_printf("Adding file system error status handler.\n");
-		http_add_handler("/*", &http_fs_error_handler);
-		db_printf("Adding error status handler.\n");
-		http_add_handler("/*", &http_status_handler);
+		http_routes_select(HTTP_ROUTES_NORMAL);
 	}
 	else
 	{
@@ -202,23 +221,10 @@ static void connected(os_signal_t mode)
 		init_captive_portal("wifiswitch");
 		//Start in network configuration mode.
 		init_http(80);
-		db_printf("Adding memory REST handler.\n");
-		http_add_handler("/rest/fw/mem", &http_rest_mem_handler);
-		db_printf("Adding version REST handler.\n");
-		http_add_handler("/rest/fw/version", &http_rest_version_handler);
-		db_printf("Adding network password REST handler.\n");
-		http_add_handler("/rest/net/password", &http_rest_net_passwd_handler);
-		db_printf("Adding network names REST handler.\n");
-		http_add_handler("/rest/net/networks", &http_rest_net_names_handler);
-		db_printf("Adding default network REST handler.\n");
-		http_add_handler("/rest/net/network", &http_rest_network_handler);
 		http_fs_init("/connect/");
-		db_printf("Adding file system handler.\n");
-		http_add_handler("/*", &http_fs_handler);
-		db_printf("Adding file system error status handler.\n");
-		http_add_handler("/*", &http_fs_error_handler);
-		db_printf("Adding error status handler.\n");
-		http_add_handler("/*", &http_status_handler);
+		http_routes_select(HTTP_ROUTES_CONFIG);
+		//Keep the network list fresh, if enabled.
+		http_rest_net_names_refresh(true);
 	}
 	//Arm the timer, run every #CHECK_TIME  ms.
 	os_timer_arm(&status_timer, CHECK_TIME, 1);